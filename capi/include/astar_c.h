@@ -18,7 +18,9 @@ typedef enum {
     PLAN_NO_PATH       = 2,
     PLAN_INVALID_ARG   = 3,
     PLAN_OUT_OF_BOUNDS = 4,
-    PLAN_MAP_ERROR     = 5
+    PLAN_MAP_ERROR     = 5,
+    PLAN_CANCELLED     = 6,
+    PLAN_RESOURCE_LIMIT = 7
 } plan_status_t;
 
 /**
@@ -41,7 +43,9 @@ typedef enum {
  * 備考:
  * - パスの並びは start→goal の順。
  * - allow_diagonal=0 のときヒューリスティックはマンハッタン、!=0 のときはオクタイル。
- * - スレッドセーフ（内部で静的状態を持たない）。
+ * - スレッドセーフ。ただし呼び出したスレッドごとに作業領域（グリッドの複製・結果バッファ・探索用アリーナ）を
+ *   thread_local で持ち、それまでで最大の地図の分を使い回すので、スレッドが終わるまで解放されない。
+ *   スレッドを終わらせずに返したいときは astar_release_thread_cache を呼ぶ（astar_plan_opts_c 等も同じ）。
  */
 plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
                             int32_t sx, int32_t sy, int32_t gx, int32_t gy,
@@ -49,6 +53,121 @@ plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
                             point_i32* path_out, int32_t* path_len_inout,
                             char* errbuf, int32_t errbuf_len);
 
+// ヒューリスティック（AUTO は allow_diagonal に応じてオクタイル/マンハッタン）
+typedef enum {
+    ASTAR_HEURISTIC_AUTO      = 0,
+    ASTAR_HEURISTIC_MANHATTAN = 1,
+    ASTAR_HEURISTIC_EUCLIDEAN = 2,
+    ASTAR_HEURISTIC_OCTILE    = 3
+} astar_heuristic_t;
+
+// 移動コスト
+typedef enum {
+    ASTAR_COST_UNIFORM   = 0, // 1 / √2 固定
+    ASTAR_COST_OCCUPANCY = 1  // 進入先セルの占有率に応じた整数コスト
+} astar_cost_mode_t;
+
+// 出力する経路の形
+typedef enum {
+    ASTAR_PATH_CELLS     = 0, // 隣接セルの列（既定）
+    ASTAR_PATH_SMOOTHED  = 1, // A* の結果を見通し判定で糸引きした折れ点列
+    ASTAR_PATH_ANY_ANGLE = 2  // Lazy Theta* による任意角度の折れ点列（ASTAR_COST_UNIFORM のみ）
+} astar_path_mode_t;
+
+// 探索エンジン（FRINGE / IDA は rows*cols の配列を持たない省メモリ版）
+typedef enum {
+    ASTAR_ENGINE_ASTAR  = 0,
+    ASTAR_ENGINE_FRINGE = 1, // Fringe Search
+    ASTAR_ENGINE_IDA    = 2  // IDA*（置換表は memory_budget_bytes の半分）
+} astar_engine_t;
+
+/**
+ * @brief astar_plan_opts_c のオプション。astar_options_init で既定値にしてから必要な項目を設定する。
+ */
+typedef struct {
+    int32_t block_threshold;    ///< これ以上のセルを障害物扱い（既定 50）
+    int32_t allow_diagonal;     ///< 0=4近傍, 非0=8近傍（既定 1）
+    int32_t heuristic;          ///< astar_heuristic_t（既定 AUTO）
+    int32_t cost_mode;          ///< astar_cost_mode_t（既定 UNIFORM）
+    const uint16_t* cost_table; ///< 占有率0..100ごとのコスト倍率（101要素）。NULLなら既定（1 + occ/10）
+    int32_t path_mode;          ///< astar_path_mode_t（既定 CELLS）
+    int32_t engine;             ///< astar_engine_t（既定 ASTAR）
+    int64_t memory_budget_bytes; ///< 探索の作業メモリの上限（0で無制限）。超えると PLAN_RESOURCE_LIMIT
+} astar_options_t;
+
+/**
+ * @brief astar_options_t を既定値で初期化する。
+ */
+void astar_options_init(astar_options_t* opts);
+
+/**
+ * @brief オプション付きの A* 経路探索。
+ *
+ * occ〜path_len_inout, errbuf, errbuf_len の意味は astar_plan_c と同じ。
+ *
+ * @param opts      オプション（NULLなら既定値）
+ * @param cost_out  経路コスト（NULL可）。ASTAR_COST_OCCUPANCY のときは 倍率×(1 / 1.414) の合計。
+ *                  SMOOTHED / ANY_ANGLE のときは折れ点列の幾何的な長さ [cell]。
+ *
+ * 備考:
+ * - ASTAR_COST_OCCUPANCY では整数コスト＋radix heap で探索し、ヒューリスティックは
+ *   最小倍率×オクタイル距離（4近傍ならマンハッタン）になるため最適性は保たれる。
+ * - SMOOTHED / ANY_ANGLE では path_out に折れ点だけが入る（隣り合う点は見通しがある）。
+ *   ANY_ANGLE と ASTAR_COST_OCCUPANCY の組み合わせは PLAN_INVALID_ARG。
+ */
+plan_status_t astar_plan_opts_c(const int32_t* occ, int32_t rows, int32_t cols,
+                                int32_t sx, int32_t sy, int32_t gx, int32_t gy,
+                                const astar_options_t* opts,
+                                point_i32* path_out, int32_t* path_len_inout,
+                                double* cost_out,
+                                char* errbuf, int32_t errbuf_len);
+
+// 経路の符号化形式。方向コード 0..7 は (dx,dy) =
+// (0,1),(0,-1),(1,0),(-1,0),(1,1),(-1,1),(1,-1),(-1,-1)
+typedef enum {
+    ASTAR_ENCODING_MOVES     = 0, // 1移動3bit、LSB から詰める（ceil(3*steps/8) バイト）
+    ASTAR_ENCODING_RUNLENGTH = 1  // 1バイト = (方向 << 5) | (回数-1)、32回を超える連続は分割
+} astar_path_encoding_t;
+
+/**
+ * @brief 経路を符号化して呼び出し側のバッファに直接書き出す A* 経路探索。
+ *
+ * occ〜opts, errbuf, errbuf_len の意味は astar_plan_opts_c と同じ（opts->path_mode は CELLS のみ）。
+ *
+ * @param encoding       astar_path_encoding_t
+ * @param buf_out        符号列の出力先（NULL可：必要バイト数だけ知りたいとき）
+ * @param buf_len_inout  入力: buf_out のバイト数。出力: 符号列のバイト数。
+ *                       足りないときは何も書かずに必要バイト数を入れて PLAN_INVALID_ARG。
+ * @param steps_out      移動回数（NULL可）。復号に必要。
+ * @param cost_out       経路コスト（NULL可）
+ *
+ * 備考:
+ * - start 座標は符号列に含まれない（呼び出し側が sx, sy を持っている）。
+ * - start==goal は steps=0、符号列は0バイト。
+ */
+plan_status_t astar_plan_encoded_c(const int32_t* occ, int32_t rows, int32_t cols,
+                                   int32_t sx, int32_t sy, int32_t gx, int32_t gy,
+                                   const astar_options_t* opts, int32_t encoding,
+                                   uint8_t* buf_out, int32_t* buf_len_inout,
+                                   int32_t* steps_out, double* cost_out,
+                                   char* errbuf, int32_t errbuf_len);
+
+/**
+ * @brief astar_plan_encoded_c の符号列を (x,y) の点列に戻す。
+ *
+ * @param path_out  出力先（steps+1 要素以上）
+ * @return 書き込んだ点数（steps+1）。引数や符号列が不正なら -1。
+ */
+int32_t astar_decode_path_c(const uint8_t* buf, int32_t buf_len, int32_t encoding, int32_t steps,
+                            int32_t sx, int32_t sy, point_i32* path_out, int32_t path_cap);
+
+/**
+ * @brief 呼び出したスレッドが経路探索のために持っている作業領域を解放する。
+ *
+ * 次に呼んだときにまた確保する。他のスレッドの作業領域には影響しない。
+ */
+void astar_release_thread_cache(void);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -2,29 +2,70 @@
 #include "astar_c.h"
 #include "engine/astar.hpp"   // あなたの既存ヘッダに合わせて調整
 #include "engine/grid.hpp"
+#include "engine/any_angle.hpp"
+#include "engine/arena.hpp"
 #include <cmath>
-#include <string>
-#include <vector>
+#include <cstring>
 #include <algorithm>
 
 using namespace engine;
 
 // エラーメッセージをバッファに書き込む
-static void put_err(char* buf, int32_t n, const std::string& msg) {
+static void put_err(char* buf, int32_t n, const char* msg) {
     if (!buf || n <= 0) return;
-    int32_t len = std::min<int32_t>(n - 1, (int32_t)msg.size());
-    std::memcpy(buf, msg.data(), len);
+    int32_t len = std::min<int32_t>(n - 1, (int32_t)std::strlen(msg));
+    std::memcpy(buf, msg, len);
     buf[len] = '\0';
 }
 
+// スレッドごとの作業領域。地図のコピーと結果は容量を、探索の作業配列はアリーナを
+// クエリ間で使い回すので、同じ規模のクエリが続けば A* の呼び出しはヒープを確保しない
+struct ThreadScratch {
+    Grid grid;
+    PlanResult result;
+};
+static ThreadScratch& thread_scratch() {
+    thread_local ThreadScratch s;
+    return s;
+}
+
+void astar_options_init(astar_options_t* opts) {
+    if (!opts) return;
+    opts->block_threshold = 50;
+    opts->allow_diagonal = 1;
+    opts->heuristic = ASTAR_HEURISTIC_AUTO;
+    opts->cost_mode = ASTAR_COST_UNIFORM;
+    opts->cost_table = nullptr;
+    opts->path_mode = ASTAR_PATH_CELLS;
+    opts->engine = ASTAR_ENGINE_ASTAR;
+    opts->memory_budget_bytes = 0;
+}
+
 plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
                             int32_t sx, int32_t sy, int32_t gx, int32_t gy,
                             int32_t block_threshold, int32_t allow_diagonal,
                             point_i32* path_out, int32_t* path_len_inout,
                             char* errbuf, int32_t errbuf_len)
 {
+    astar_options_t opts;
+    astar_options_init(&opts);
+    opts.block_threshold = block_threshold;
+    opts.allow_diagonal = allow_diagonal;
+    return astar_plan_opts_c(occ, rows, cols, sx, sy, gx, gy, &opts,
+                             path_out, path_len_inout, nullptr, errbuf, errbuf_len);
+}
+
+// 検証・Grid構築・探索・ステータス変換までの共通部分（失敗時は errbuf に理由）
+static plan_status_t plan_common(const int32_t* occ, int32_t rows, int32_t cols,
+                                 int32_t sx, int32_t sy, int32_t gx, int32_t gy,
+                                 const astar_options_t* opts, PathFormat format, PlanResult& res,
+                                 char* errbuf, int32_t errbuf_len)
+{
+    astar_options_t o;
+    if (opts) o = *opts; else astar_options_init(&o);
+
     // 1) 引数バリデーション（最小限）
-    if (!occ || rows <= 0 || cols <= 0 || !path_len_inout) {
+    if (!occ || rows <= 0 || cols <= 0) {
         put_err(errbuf, errbuf_len, "invalid arguments");
         return PLAN_MAP_ERROR;
     }
@@ -36,7 +77,7 @@ plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
     }
 
   // 2) Grid 構築（占有率→ブール通行可否へ変換はA*内部でやってもOK。ここではGridに占有率を詰める想定）
-    Grid g;
+    Grid& g = thread_scratch().grid;
     g.rows = rows;
     g.cols = cols;
     g.occ.resize((size_t)rows * (size_t)cols);
@@ -49,17 +90,54 @@ plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
 
     // 3) コンフィグ
     AstarConfig cfg;
-    cfg.allow_diagonal = (allow_diagonal != 0);
-    cfg.block_threshold = block_threshold;
-    cfg.heuristic = cfg.allow_diagonal ? Heuristic::Octile : Heuristic::Manhattan;
+    cfg.allow_diagonal = (o.allow_diagonal != 0);
+    cfg.block_threshold = o.block_threshold;
+    switch (o.heuristic) {
+    case ASTAR_HEURISTIC_MANHATTAN: cfg.heuristic = Heuristic::Manhattan; break;
+    case ASTAR_HEURISTIC_EUCLIDEAN: cfg.heuristic = Heuristic::Euclidean; break;
+    case ASTAR_HEURISTIC_OCTILE:    cfg.heuristic = Heuristic::Octile; break;
+    default: cfg.heuristic = cfg.allow_diagonal ? Heuristic::Octile : Heuristic::Manhattan; break;
+    }
+    OccupancyCostTable table{};
+    if (o.cost_mode == ASTAR_COST_OCCUPANCY) {
+        cfg.cost_mode = CostMode::OccupancyWeighted;
+        if (o.cost_table) {
+            std::copy(o.cost_table, o.cost_table + table.size(), table.begin());
+            cfg.cost_table = &table;
+        }
+    }
+    cfg.path_format = format;
+    switch (o.engine) {
+    case ASTAR_ENGINE_FRINGE: cfg.engine = SearchEngine::Fringe; break;
+    case ASTAR_ENGINE_IDA:    cfg.engine = SearchEngine::IdaStar; break;
+    default:                  cfg.engine = SearchEngine::AStar; break;
+    }
+    cfg.memory_budget_bytes = o.memory_budget_bytes > 0 ? (size_t)o.memory_budget_bytes : 0;
+
+    // 作業配列はスレッドのアリーナから（前のクエリの分は捨てる）
+    QueryArena& arena = thread_query_arena();
+    arena.reset();
+    cfg.memory = &arena;
 
     // 4) 計画
-    auto out = astar_plan_ex(
-        g,
-        /*start(y,x)*/ { sy, sx },
-        /*goal (y,x)*/ { gy, gx },
-        cfg
-    );
+    PlanStatus status;
+    if (o.path_mode == ASTAR_PATH_ANY_ANGLE) {
+        auto out = lazy_theta_plan_ex(g, { sy, sx }, { gy, gx }, cfg);
+        status = out.status;
+        if (out.result) res = std::move(*out.result);
+    } else {
+        status = astar_plan_into(
+            g,
+            /*start(y,x)*/ { sy, sx },
+            /*goal (y,x)*/ { gy, gx },
+            cfg,
+            res
+        );
+        if (o.path_mode == ASTAR_PATH_SMOOTHED && status == PlanStatus::Ok) {
+            res.path = smooth_path(g, cfg, res.path);
+            res.stats.cost = polyline_length(res.path);
+        }
+    }
 
     // 5) ステータス振り分け & エラーメッセージ
     auto to_c_status = [](PlanStatus s)->plan_status_t {
@@ -69,6 +147,8 @@ plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
         case PlanStatus::InvalidArg:  return PLAN_INVALID_ARG;
         case PlanStatus::OutOfBounds: return PLAN_OUT_OF_BOUNDS;
         case PlanStatus::MapError:    return PLAN_MAP_ERROR;
+        case PlanStatus::Cancelled:   return PLAN_CANCELLED;
+        case PlanStatus::ResourceLimit: return PLAN_RESOURCE_LIMIT;
         }
         return PLAN_MAP_ERROR;
     };
@@ -81,48 +161,59 @@ plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
         case PlanStatus::InvalidArg:  return "invalid argument";
         case PlanStatus::OutOfBounds: return "out of bounds";
         case PlanStatus::MapError:    return "map error";
+        case PlanStatus::Cancelled:   return "cancelled";
+        case PlanStatus::ResourceLimit: return "memory budget exceeded";
         }
         return "unknown error";
     };
 
-    plan_status_t st = to_c_status(out.status);
+    plan_status_t st = to_c_status(status);
     if (st != PLAN_OK) {
-        const char* msg = status_message(out.status);
+        const char* msg = status_message(status);
         put_err(errbuf, errbuf_len, (*msg ? msg : "planning failed"));
-        *path_len_inout = 0;
-        return st;
     }
+    return st;
+}
 
+plan_status_t astar_plan_opts_c(const int32_t* occ, int32_t rows, int32_t cols,
+                                int32_t sx, int32_t sy, int32_t gx, int32_t gy,
+                                const astar_options_t* opts,
+                                point_i32* path_out, int32_t* path_len_inout,
+                                double* cost_out,
+                                char* errbuf, int32_t errbuf_len)
+{
+    if (!path_len_inout) {
+        put_err(errbuf, errbuf_len, "invalid arguments");
+        return PLAN_MAP_ERROR;
+    }
+    PlanResult& res = thread_scratch().result;
+    plan_status_t st = plan_common(occ, rows, cols, sx, sy, gx, gy, opts, PathFormat::Cells, res,
+                                   errbuf, errbuf_len);
     // 6) パス出力（start→goal）。start==goal は長さ0で返す設計。
     // 結果がない場合はエラー
-    const auto& opt_path = out.result; // std::optional<PlanResult>
-    if (!opt_path.has_value()) {
-        put_err(errbuf, errbuf_len, "ok but empty result");
+    if (st != PLAN_OK) {
         *path_len_inout = 0;
-        return PLAN_OK;
+        return st;
     }
 
+    if (cost_out) *cost_out = res.stats.cost;
+
     // 結果がある場合はパスを出力
-    const auto& path_rc = opt_path->path; // (r,c) の配列 PlanResult の pathメンバ
+    const auto& path_rc = res.path; // (r,c) の配列 PlanResult の pathメンバ
     // start==goal のときは0
     if (path_rc.size() == 1 && path_rc.front().r == sy && path_rc.front().c == sx && sx == gx && sy == gy) {
         *path_len_inout = 0;
         return PLAN_OK;
     }
 
-    // (r,c)->(x,y) に変換
-    std::vector<point_i32> out_xy;
-    out_xy.reserve(path_rc.size());
-    for (auto& p : path_rc) {
-        out_xy.push_back({ (int32_t)p.c, (int32_t)p.r });
-    }
-
     int32_t cap = *path_len_inout;
-    int32_t need = (int32_t)out_xy.size();
+    int32_t need = (int32_t)path_rc.size();
     if (path_out && cap > 0) {
         int32_t wr = std::min(cap, need);
-        // .data()で連続メモリの先頭ポインタを取得
-        std::memcpy(path_out, out_xy.data(), (size_t)wr * sizeof(point_i32));
+        // (r,c)->(x,y) に変換しながら呼び出し側のバッファへ直接書く
+        for (int32_t i = 0; i < wr; ++i) {
+            path_out[i] = { (int32_t)path_rc[i].c, (int32_t)path_rc[i].r };
+        }
         *path_len_inout = wr;
         if (wr < need) {
             put_err(errbuf, errbuf_len, "path buffer too small (truncated)");
@@ -134,3 +225,81 @@ plan_status_t astar_plan_c(const int32_t* occ, int32_t rows, int32_t cols,
 
     return PLAN_OK;
 }
+
+plan_status_t astar_plan_encoded_c(const int32_t* occ, int32_t rows, int32_t cols,
+                                   int32_t sx, int32_t sy, int32_t gx, int32_t gy,
+                                   const astar_options_t* opts, int32_t encoding,
+                                   uint8_t* buf_out, int32_t* buf_len_inout,
+                                   int32_t* steps_out, double* cost_out,
+                                   char* errbuf, int32_t errbuf_len)
+{
+    if (!buf_len_inout || (encoding != ASTAR_ENCODING_MOVES && encoding != ASTAR_ENCODING_RUNLENGTH) ||
+        (opts && opts->path_mode != ASTAR_PATH_CELLS)) {
+        put_err(errbuf, errbuf_len, "invalid arguments");
+        if (buf_len_inout) *buf_len_inout = 0;
+        return PLAN_INVALID_ARG;
+    }
+    PlanResult& res = thread_scratch().result;
+    const PathFormat format = (encoding == ASTAR_ENCODING_RUNLENGTH) ? PathFormat::RunLength : PathFormat::Moves;
+    plan_status_t st = plan_common(occ, rows, cols, sx, sy, gx, gy, opts, format, res, errbuf, errbuf_len);
+    if (st != PLAN_OK || !res.compact) {
+        *buf_len_inout = 0;
+        return st;
+    }
+
+    const CompactPath& cp = *res.compact;
+    if (steps_out) *steps_out = cp.steps;
+    if (cost_out) *cost_out = res.stats.cost;
+    const int32_t need = (int32_t)cp.data.size();
+    if (buf_out && *buf_len_inout < need) {
+        // 途中までの符号列は復号できないので何も書かない
+        put_err(errbuf, errbuf_len, "encoded buffer too small");
+        *buf_len_inout = need;
+        return PLAN_INVALID_ARG;
+    }
+    if (buf_out && need > 0) std::memcpy(buf_out, cp.data.data(), (size_t)need);
+    *buf_len_inout = need;
+    return PLAN_OK;
+}
+
+int32_t astar_decode_path_c(const uint8_t* buf, int32_t buf_len, int32_t encoding, int32_t steps,
+                            int32_t sx, int32_t sy, point_i32* path_out, int32_t path_cap)
+{
+    if ((!buf && buf_len > 0) || buf_len < 0 || steps < 0 || !path_out || path_cap <= steps) return -1;
+    if (encoding != ASTAR_ENCODING_MOVES && encoding != ASTAR_ENCODING_RUNLENGTH) return -1;
+
+    // (dx,dy) 方向表（astar_c.h のコード順）
+    static const int32_t dxy[8][2] = {{0,1},{0,-1},{1,0},{-1,0},{1,1},{-1,1},{1,-1},{-1,-1}};
+    int32_t n = 0;
+    point_i32 cur = { sx, sy };
+    path_out[n++] = cur;
+    auto step = [&](int code) {
+        if (n > steps) return false;
+        cur.x += dxy[code][0];
+        cur.y += dxy[code][1];
+        path_out[n++] = cur;
+        return true;
+    };
+    if (encoding == ASTAR_ENCODING_RUNLENGTH) {
+        for (int32_t i = 0; i < buf_len; ++i) {
+            for (int k = (buf[i] & 31) + 1; k > 0; --k) {
+                if (!step(buf[i] >> 5)) return -1;
+            }
+        }
+    } else {
+        if ((int64_t)buf_len * 8 < (int64_t)steps * 3) return -1;
+        for (int32_t i = 0; i < steps; ++i) {
+            const int64_t bit = (int64_t)i * 3;
+            unsigned v = buf[bit >> 3] >> (bit & 7);
+            if ((bit & 7) > 5) v |= (unsigned)buf[(bit >> 3) + 1] << (8 - (bit & 7));
+            step((int)(v & 7u));
+        }
+    }
+    return n == steps + 1 ? n : -1;
+}
+
+void astar_release_thread_cache(void) {
+    ThreadScratch& s = thread_scratch();
+    s = ThreadScratch{}; // 容量ごと捨てる
+    thread_query_arena().release();
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// ビットパックした通行可能マスク上の見通し判定
+// セル中心どうしを結ぶ線分が触れる全セル（角で接するものも含む）が通行可能なら見通しあり。
+// 斜め1マスの移動では A* のコーナーカット禁止と同じ判定になる
+class LineOfSight {
+public:
+    // 通行可否は cfg の block_threshold と膨張で決める
+    LineOfSight(const Grid& g, const AstarConfig& cfg);
+
+    bool free(Cell a) const;
+    bool visible(Cell a, Cell b) const;
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+private:
+    // 行 r の列 [c0, c1] が全て通行可能か（64セルずつワード単位で調べる）
+    bool row_free(int r, int c0, int c1) const;
+
+    int rows_ = 0;
+    int cols_ = 0;
+    int words_ = 0;              // 1行あたりのワード数
+    std::vector<uint64_t> bits_; // 通行可能なら1（行ごとにワード境界から始める）
+};
+
+// 折れ点列の幾何的な長さ [cell]
+double polyline_length(const std::vector<Cell>& path);
+
+// Lazy Theta*（任意角度の経路）。path は折れ点だけの列で、cost はその長さ
+// ヒューリスティックは常にユークリッド。対応するのは CostMode::Uniform のみ（それ以外は InvalidArg）
+PlanOutcome lazy_theta_plan_ex(const Grid& g, Cell start, Cell goal, const AstarConfig& cfg);
+
+// 既存の経路の糸引き（string pulling）。見通しのある限り先の点へ飛ばし、折れ点だけを残す
+// 隣り合う点どうしが見通せる経路（astar_plan_ex などの結果）を前提とする
+std::vector<Cell> smooth_path(const LineOfSight& los, const std::vector<Cell>& path);
+std::vector<Cell> smooth_path(const Grid& g, const AstarConfig& cfg, const std::vector<Cell>& path);
+
+} // namespace engine
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace engine {
+
+// クエリごとに巻き戻して使う単調増加アリーナ（スレッドセーフではない）
+// deallocate は何もせず、reset で全体を先頭に戻す。足りなければ上流から新しいチャンクを取り、
+// reset のときに合計サイズの1チャンクへまとめ直すので、同じ規模のクエリが続けば上流への確保は0回になる
+class QueryArena : public std::pmr::memory_resource {
+public:
+    explicit QueryArena(size_t initial_bytes = 0,
+                        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~QueryArena() override;
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+    // 確保したものを全て捨てる（このアリーナから確保したコンテナは先に破棄しておくこと）
+    void reset();
+    // reset して上流から確保したチャンクも全て返す
+    void release();
+
+    size_t capacity() const { return capacity_; } // 上流から確保しているバイト数
+    size_t used() const { return used_; }         // 今のクエリで確保したバイト数
+    uint64_t upstream_allocations() const { return upstream_allocs_; }
+
+private:
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+    struct Chunk {
+        char* data;
+        size_t size;
+    };
+    void add_chunk(size_t min_bytes);
+
+    std::pmr::memory_resource* upstream_;
+    std::vector<Chunk> chunks_;
+    size_t cur_ = 0;      // 使用中のチャンク
+    size_t offset_ = 0;   // chunks_[cur_] の使用済みバイト数
+    size_t capacity_ = 0;
+    size_t used_ = 0;
+    uint64_t upstream_allocs_ = 0;
+};
+
+// 呼び出したスレッド専用のアリーナ（C API と CLI のクエリで使い回す）
+QueryArena& thread_query_arena();
+
+} // namespace engine
@@ -1,7 +1,13 @@
 #pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
 #include <optional>
 #include "grid.hpp"
+#include "distance.hpp"
 
 namespace engine {
 
@@ -11,11 +17,53 @@ struct Cell { int r, c; }; // r=row, c=col
 // ヒューリスティック
 enum class Heuristic { Manhattan, Euclidean, Octile };
 
+// 半径の単位
+enum class RadiusUnit { Cells, Meters };
+
+// 移動コストの決め方
+enum class CostMode {
+    Uniform,          // 1 / √2 固定
+    OccupancyWeighted // 進入先セルの占有率に応じた整数コスト（基本コスト×倍率）
+};
+
+// 経路の出力形式
+enum class PathFormat {
+    Cells,    // PlanResult::path にセル列
+    Moves,    // PlanResult::compact に start + 移動1回3bitのコード列
+    RunLength // PlanResult::compact に start + (方向3bit, 回数-1 5bit) の1バイト列
+};
+
+// 探索エンジン
+enum class SearchEngine {
+    AStar,  // rows*cols の配列 + ヒープ（最速）
+    Fringe, // Fringe Search。訪問ビットマップ + 2本のリスト + 訪問セルだけのハッシュ表
+    IdaStar // IDA*。深さ分のスタック + memory_budget_bytes に収まる置換表（小さいほど再展開が増える）。
+            // 始める前にセル数/4 バイトの塗りつぶしで到達可能性を調べる（行けなければすぐ NoPath）
+            // stats.max_open はスタックの最大深さ
+};
+
+// 占有率(0..100)ごとの移動コスト倍率
+using OccupancyCostTable = std::array<uint16_t, 101>;
+
+// 既定の倍率表（1 + occ/10）
+OccupancyCostTable default_occupancy_costs();
+
 // 初期設定
 struct AstarConfig {
     bool allow_diagonal = true; // 斜めがありか否か
     Heuristic heuristic = Heuristic::Octile;
     int block_threshold = 50; // 50以上で障害物認定
+    float inflation_radius = 0.0f; // 障害物の膨張半径（ロボット半径）。0で無効
+    RadiusUnit inflation_unit = RadiusUnit::Cells; // Meters のときは Grid::resolution で換算
+    const DistanceField* distance_field = nullptr; // キャッシュした距離場（nullptrなら必要時に毎回計算）
+    CostMode cost_mode = CostMode::Uniform;
+    const OccupancyCostTable* cost_table = nullptr; // OccupancyWeighted の倍率表（nullptrなら既定）
+    const std::atomic<bool>* cancel = nullptr; // true になったら展開の区切りで打ち切って Cancelled を返す
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(); // 過ぎたら cancel と同様に打ち切る
+    PathFormat path_format = PathFormat::Cells; // Cells 以外は astar_plan_ex（と pyramid_plan_ex）で有効
+    SearchEngine engine = SearchEngine::AStar;
+    size_t memory_budget_bytes = 0; // 探索の作業メモリの上限（0で無制限）。超えると ResourceLimit
+    std::pmr::memory_resource* memory = nullptr; // A* の作業配列と open list の確保先（nullptrなら既定のヒープ）
 };
 
 //　比較のための計測
@@ -23,21 +71,38 @@ struct PlanStats {
     double cost = 0.0; // 経路コスト
     int expanded = 0; // 展開したノード数
     double time_ms = 0.0; // 経過時間
+    int max_open = 0; // open listの最大サイズ
+    size_t peak_bytes = 0; // 作業メモリの最大値（配列・リスト・表の確保量の見積もり）
+};
+
+// 移動で符号化した経路。方向コードは 0..7 で (dr,dc) = (1,0),(-1,0),(0,1),(0,-1),(1,1),(1,-1),(-1,1),(-1,-1)
+struct CompactPath {
+    PathFormat format = PathFormat::Moves;
+    Cell start{0, 0};
+    int32_t steps = 0;         // 移動回数（セル数-1）
+    std::vector<uint8_t> data; // Moves: LSB から詰めた3bitコード / RunLength: (方向 << 5) | (回数-1)
 };
 
 // 結果
 struct PlanResult {
-    std::vector<Cell> path; // 経路
+    std::vector<Cell> path; // 経路（path_format が Cells 以外なら空）
     PlanStats stats; // 計測
+    std::optional<CompactPath> compact; // path_format が Cells 以外のときの経路
 };
 
+// セル列との相互変換（隣り合わないセルを含む経路は encode できず nullopt）
+std::optional<CompactPath> encode_path(const std::vector<Cell>& path, PathFormat format);
+std::vector<Cell> decode_path(const CompactPath& cp);
+
 // 失敗理由の列挙
 enum class PlanStatus {
     Ok = 0,
     NoPath,        // 経路が見つからない
     OutOfBounds,   // start/goal がグリッド外
     InvalidArg,    // start/goal が障害物 等
-    MapError       // 行列サイズ不正などロード失敗系
+    MapError,      // 行列サイズ不正などロード失敗系
+    Cancelled,     // cfg.cancel / cfg.deadline による中断
+    ResourceLimit  // memory_budget_bytes に収まらない
 };
 
 // 結果+ステータス
@@ -49,6 +114,11 @@ struct PlanOutcome {
 // 上位互換API（新設）
 PlanOutcome astar_plan_ex(const Grid& g, Cell start, Cell goal, const AstarConfig& cfg);
 
+// astar_plan_ex と同じ探索で、結果を呼び出し側の out に書く（out.path / out.compact の容量を使い回す）
+// cfg.memory にクエリごとに reset するアリーナを渡せば、定常状態では A* 1回あたりのヒープ確保が0回になる
+// 失敗したときの out の中身は未規定（容量は残る）
+PlanStatus astar_plan_into(const Grid& g, Cell start, Cell goal, const AstarConfig& cfg, PlanResult& out);
+
 // メイン関数
 std::optional<PlanResult> // これは戻り値の型
 astar_plan(const Grid& g, Cell start, Cell goal, const AstarConfig& cfg);
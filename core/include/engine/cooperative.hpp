@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// (セル, 時刻) -> エージェント番号 の予約表（開番地法、キーと値を別配列に持つ）
+class ReservationTable {
+public:
+    explicit ReservationTable(size_t expected = 0);
+
+    // 空いていれば agent で予約して true（既に予約があれば何もせず false）
+    bool reserve(int cell, int t, int agent);
+    // 予約しているエージェント（なければ -1）
+    int occupant(int cell, int t) const;
+
+    void clear();
+    size_t size() const { return size_; }
+    size_t bytes() const { return keys_.capacity() * sizeof(uint64_t) + vals_.capacity() * sizeof(int32_t); }
+
+private:
+    static constexpr uint64_t kEmpty = ~0ull;
+    static uint64_t key(int cell, int t) { return (static_cast<uint64_t>(t) << 32) | static_cast<uint32_t>(cell); }
+    size_t slot_of(uint64_t k) const;
+    void grow();
+
+    std::vector<uint64_t> keys_;
+    std::vector<int32_t> vals_;
+    size_t size_ = 0;
+    int shift_ = 64;
+};
+
+struct AgentTask {
+    Cell start{0, 0};
+    Cell goal{0, 0};
+};
+
+struct CooperativeConfig {
+    int horizon = 0; // 探索する最大時刻（0 なら 4*(rows+cols)）
+};
+
+// 1台分の結果。path[t] が時刻 t の位置（待機は同じセルが続き、到着後はゴールに留まる）
+struct AgentPath {
+    PlanStatus status = PlanStatus::NoPath;
+    std::vector<Cell> path;
+    double cost = 0.0; // 待機も直進1回分（重み付きならそのセルの倍率を掛ける）
+    int expanded = 0;
+};
+
+struct CooperativeStats {
+    int planned = 0;
+    int failed = 0;
+    int makespan = 0;            // 全員が到着する時刻
+    int64_t expanded = 0;        // 時空間ノードの展開数の合計
+    double time_ms = 0.0;
+    double agents_per_sec = 0.0; // 処理したエージェント数 / 所要時間
+    size_t reservations = 0;
+    size_t table_bytes = 0;
+};
+
+struct CooperativeResult {
+    std::vector<AgentPath> agents; // tasks と同じ順
+    CooperativeStats stats;
+};
+
+struct CooperativeOutcome {
+    PlanStatus status = PlanStatus::MapError; // 全員成功で Ok、失敗した台があれば NoPath（result は返す）
+    std::optional<CooperativeResult> result;
+};
+
+// Cooperative A*: tasks の順（先頭ほど優先）に時空間 A* で計画し、共有の予約表に書き込む
+// 後の台は予約済みの (セル, 時刻) と、すれ違い（同じ辺を逆向きに同時に通る）を避ける。
+// ヒューリスティックは台ごとのゴールからの逆向き探索（必要な分だけ再開する RRA*）による真の距離。
+// 近傍・通行判定・コストは astar_plan_ex と同じ（engine / path_format / memory_budget_bytes は使わない）。
+// 失敗した台は t=0 からずっとスタートに留まり、全員がそれを避ける（先に計画した台が通っていたら
+// その台を留まるものとして全員を計画し直すので、返す経路どうしは衝突しない）
+CooperativeOutcome cooperative_plan_ex(const Grid& g, const std::vector<AgentTask>& tasks,
+                                       const AstarConfig& cfg, const CooperativeConfig& ccfg = {});
+
+} // namespace engine
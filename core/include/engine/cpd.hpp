@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// CPD の構築・サイズの計測（どのマップに使う価値があるかの判断用）
+struct CpdStats {
+    double build_ms = 0.0; // 構築時間
+    size_t bytes = 0;      // メモリ使用量（配列の合計）
+    size_t runs = 0;       // 連長圧縮後のラン数の合計
+    int sources = 0;       // 通行可能なセル数（= 行数）
+    int threads = 0;       // 構築に使ったスレッド数
+};
+
+// 圧縮経路データベース（Compressed Path Database）
+// 各 source について「各 target への最適経路の最初の一手」をセル順序に沿って連長圧縮したもの
+struct CompressedPathDb {
+    int rows = 0;
+    int cols = 0;
+    bool allow_diagonal = true;
+    int block_threshold = 50;
+    uint64_t fingerprint = 0;      // 構築元の地図と設定の指紋（読み込み時の照合用）
+    std::vector<uint32_t> rank;    // セル -> 順序上の位置（近いセルが近い位置になるDFS順）
+    std::vector<int32_t> comp;     // セル -> 連結成分ID（障害物は-1）
+    std::vector<uint32_t> offsets; // セル -> runs の開始位置（rows*cols+1 要素）
+    std::vector<uint32_t> runs;    // (開始位置 << 4) | 移動方向
+    CpdStats stats;
+};
+
+// 全 source から Dijkstra を並列に実行して構築する（num_threads <= 0 ならハードウェアのスレッド数）
+// 対応するのは CostMode::Uniform のみ。グリッド不正や OccupancyWeighted のときは nullopt
+std::optional<CompressedPathDb> build_cpd(const Grid& g, const AstarConfig& cfg, int num_threads = 0);
+
+// 探索なしで最初の一手を繰り返し引いて経路を復元する（stats.expanded は常に0）
+PlanOutcome cpd_plan_ex(const CompressedPathDb& db, Cell start, Cell goal);
+
+// バイナリ形式での保存/読み込み
+// 読み込みは g と cfg（斜め・閾値・膨張半径）が構築時と同じでなければ nullopt（古いファイルを使わない）
+bool save_cpd(const CompressedPathDb& db, const std::string& path);
+std::optional<CompressedPathDb> load_cpd(const std::string& path, const Grid& g, const AstarConfig& cfg);
+
+} // namespace engine
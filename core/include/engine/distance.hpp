@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include "grid.hpp"
+
+namespace engine {
+
+// 最寄りの障害物セル（中心）までのユークリッド距離 [cell]
+struct DistanceField {
+    int rows = 0;
+    int cols = 0;
+    int block_threshold = 50; // 計算に使った障害物のしきい値
+    std::vector<float> dist;  // row-major。障害物セルは0、障害物がなければ+inf
+
+    inline float at(int r, int c) const { return dist[r*cols + c]; }
+};
+
+// 線形時間のユークリッド距離変換（列方向→行方向の分離可能な2パス）
+// num_threads <= 0 のときはハードウェアのスレッド数を使う
+DistanceField compute_distance_field(const Grid& g, int block_threshold = 50, int num_threads = 0);
+
+} // namespace engine
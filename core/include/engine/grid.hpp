@@ -14,6 +14,7 @@ struct Grid {
     float origin_x = 0.0f;   // world原点
     float origin_y = 0.0f;
     std::vector<uint8_t> occ; // row-major: occ[r*cols + c] (occ = occupancy)
+    uint64_t version = 0;     // 地図の版（経路キャッシュのキー。地図を差し替えたら上げる）
 
     // メンバ関数
     inline bool in(int r, int c) const { return r>=0 && c>=0 && r<rows && c<cols; }
@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include <optional>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// 複数ゴールの集合。座標は SoA（行・列を別配列）で持ち、最小ヒューリスティックをまとめて計算する
+class GoalSet {
+public:
+    // bucket_size: 空間バケットの一辺 [cell]。0 なら自動（32個以下ならバケットなし、多ければゴールの数と広がりから決める）、
+    //              負ならバケットなし
+    explicit GoalSet(const std::vector<Cell>& goals, int bucket_size = 0);
+
+    // 全ゴールに対するヒューリスティックの最小値
+    // octile_k: Octile の斜め1歩の追加分（斜めコスト - 1）。整数コストの 1.414 なら 0.414 を渡す
+    // cancel: バケットの間で調べ、true なら 0（許容的な下界）を返す
+    double min_heuristic(int r, int c, Heuristic h, double octile_k = kOctileK,
+                         const std::atomic<bool>* cancel = nullptr) const;
+
+    static constexpr double kOctileK = 0.41421356237309504880; // √2 - 1
+
+    int size() const { return static_cast<int>(rows_.size()); }
+    bool bucketed() const { return !b_begin_.empty(); }
+
+private:
+    double scan(int r, int c, Heuristic h, double octile_k, int begin, int end) const;
+
+    // ゴール座標（バケット順に並べ替え済み）
+    std::vector<float> rows_, cols_;
+    // バケット（バウンディングボックスと rows_/cols_ 上の範囲）
+    std::vector<float> b_r0_, b_r1_, b_c0_, b_c1_;
+    std::vector<int> b_begin_, b_end_;
+};
+
+struct MultiGoalOutcome {
+    PlanStatus status = PlanStatus::MapError;
+    std::optional<PlanResult> result;
+    int goal_index = -1; // 到達したゴールの goals 上の添字
+};
+
+// 最も近いゴールへの経路（最初に open list から取り出したゴールで停止）
+// 障害物上のゴールは無視し、使えるゴールが1つもなければ InvalidArg
+MultiGoalOutcome astar_plan_multi_ex(const Grid& g, Cell start, const std::vector<Cell>& goals,
+                                     const AstarConfig& cfg);
+
+} // namespace engine
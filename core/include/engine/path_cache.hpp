@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// キャッシュの計測
+struct PathCacheStats {
+    uint64_t hits = 0;         // start/goal が一致した
+    uint64_t subpath_hits = 0; // キャッシュ済み経路の部分経路で答えた
+    uint64_t misses = 0;
+    uint64_t evictions = 0;    // 容量超過で追い出した件数
+    uint64_t invalidated = 0;  // 領域更新で無効化した件数
+    size_t entries = 0;
+    size_t bytes = 0;          // 見積もりメモリ使用量
+};
+
+// 探索結果に影響する設定のハッシュ（distance_field はキャッシュなので含めない）
+uint64_t config_hash(const AstarConfig& cfg);
+
+// PlanResult の LRU キャッシュ（スレッドセーフ、メモリ上限付き）
+// キーは (地図の版, start, goal, 設定ハッシュ)。最適経路の部分経路も最適なので、
+// start と goal が両方キャッシュ済み経路上にあればその区間を返す
+class PathCache {
+public:
+    explicit PathCache(size_t max_bytes);
+
+    // 見つからなければ nullopt（stats.expanded は0、cost は区間のコスト）
+    std::optional<PlanResult> find(const Grid& g, const AstarConfig& cfg, Cell start, Cell goal);
+
+    // g と cfg で求めた結果を登録する（Uniform なら逆向きの部分経路にも使う）
+    void insert(const Grid& g, const AstarConfig& cfg, const PlanResult& result);
+
+    // 矩形 [r0,r1]x[c0,c1] の変化で使えなくなりうる経路を全ての版から削除し、削除件数を返す
+    // 経路のセルから 1 + 膨張半径 以内（チェビシェフ距離）が矩形にかかれば削除する
+    // （斜め移動の両脇のセルと、膨張で通れなくなるセルを含めるため）
+    // 障害物を取り除いた更新ではより短い経路ができうるので、その場合は Grid::version を上げること
+    size_t invalidate_region(int r0, int c0, int r1, int c1);
+
+    void clear();
+    PathCacheStats stats() const;
+
+private:
+    struct Entry {
+        uint64_t version, cfg;
+        std::vector<Cell> path;
+        std::vector<double> prefix; // prefix[i] = path[0..i] のコスト
+        PlanStats stats;
+        bool reversible;
+        int margin;     // 無効化の判定で矩形を広げる幅 = 1 + 膨張半径 [cell]
+        uint64_t serial; // 登録順の通し番号（セル索引の並び順）
+        size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    struct Key {
+        uint64_t version, cfg;
+        int r0, c0, r1, c1; // セル索引では r1=c1=0
+        bool operator==(const Key& o) const {
+            return version == o.version && cfg == o.cfg && r0 == o.r0 && c0 == o.c0 && r1 == o.r1 && c1 == o.c1;
+        }
+    };
+    struct KeyHash { size_t operator()(const Key& k) const; };
+
+    void erase(EntryList::iterator it);
+
+    mutable std::mutex mu_;
+    size_t max_bytes_;
+    EntryList lru_; // 先頭が最近使ったもの
+    std::unordered_map<Key, EntryList::iterator, KeyHash> exact_;
+    // セル -> そのセルを通る経路（serial の昇順。最適経路は同じセルを2度通らないので1経路1要素）
+    struct CellRef {
+        EntryList::iterator it;
+        uint64_t serial;
+        int pos; // 経路上の位置
+    };
+    std::unordered_map<Key, std::vector<CellRef>, KeyHash> by_cell_;
+    uint64_t next_serial_ = 0;
+    PathCacheStats stats_;
+};
+
+// キャッシュを引き、なければ astar_plan_ex で探索して登録する
+PlanOutcome cached_plan_ex(PathCache& cache, const Grid& g, Cell start, Cell goal, const AstarConfig& cfg);
+
+} // namespace engine
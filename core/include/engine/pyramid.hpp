@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <optional>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// 粗いセルの占有率の決め方
+enum class DownsampleRule {
+    AnyBlocked,   // 細かいセルが1つでも障害物なら粗いセルも障害物（保守的）
+    MaxOccupancy  // 細かいセルの占有率の最大値
+};
+
+// 多解像度グリッド（levels[0] が元のグリッド、添字が大きいほど粗い）
+struct GridPyramid {
+    int factor = 2;           // 1段あたりの縮小率
+    std::vector<Grid> levels;
+};
+
+// ピラミッド構築（num_levels は元のグリッドを含む段数）
+GridPyramid build_pyramid(const Grid& g, int num_levels, int factor,
+                          DownsampleRule rule = DownsampleRule::AnyBlocked,
+                          int block_threshold = 50);
+
+// 粗→細探索の設定
+struct PyramidConfig {
+    int corridor_radius = 1;   // 粗い経路の周囲何セルを回廊とするか（1つ上の段のセル単位）
+    bool fallback_full = true; // 回廊内に経路がなければ全域探索する
+};
+
+// 粗→細探索の計測（全域探索との比較用）
+struct PyramidStats {
+    int coarse_expanded = 0; // 粗い段での展開数の合計
+    int coarse_max_open = 0; // 粗い段での open list 最大サイズ
+    int corridor_cells = 0;  // 最下段の回廊セル数
+    int total_cells = 0;     // 最下段の全セル数
+    bool fallback = false;   // 全域探索にフォールバックしたか
+};
+
+struct PyramidPlanOutcome {
+    PlanStatus status = PlanStatus::MapError;
+    std::optional<PlanResult> result; // stats は最下段（最終）探索の値
+    PyramidStats pyramid;
+};
+
+// 最も粗い段から探索し、1段ずつ回廊内に限定して細かい段を探索する
+PyramidPlanOutcome pyramid_plan_ex(const GridPyramid& p, Cell start, Cell goal,
+                                   const AstarConfig& cfg, const PyramidConfig& pcfg = {});
+
+} // namespace engine
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "grid.hpp"
+#include "astar.hpp"
+#include "distance.hpp"
+
+namespace engine {
+
+struct RealtimeConfig {
+    int lookahead = 64; // 1 tick の先読みで展開するノード数の上限
+    int max_moves = 4;  // 1 tick で返す移動数の上限（0以下なら先読みの端まで全部）
+};
+
+// 1 tick の結果
+struct RealtimeStep {
+    PlanStatus status = PlanStatus::MapError; // 到達できる範囲を先読みで展開しきると NoPath
+    std::vector<Cell> moves;                  // 次に進むセル（現在地は含まない）
+    bool at_goal = false;                     // 現在地がゴール（moves は空）
+    int expanded = 0;                         // この tick の展開数（<= lookahead）
+    int updated = 0;                          // 学習で値が上がったセル数
+};
+
+// 先読みの大きさが一定の実時間探索（LSS-LRTA*）
+// tick ごとに現在地から lookahead 個だけ A* で展開し、閉じたセルのヒューリスティックを
+// Dijkstra 風に更新して学習表に残し、open list の最良セルへ向かう移動を返す。
+// 学習表は tick をまたいで保持するので、同じゴールへの往復を重ねると最適経路に収束する。
+// 近傍・通行判定・整数コストは astar_plan_ex と同じ（Uniform の斜めは 1.414）
+class RealtimeAgent {
+public:
+    // g は agent より長く生きること。occ は tick の間に書き換えてよい（障害物が消えたら reset_learning）
+    RealtimeAgent(const Grid& g, Cell goal, const AstarConfig& cfg = {}, const RealtimeConfig& rcfg = {});
+    RealtimeAgent(const RealtimeAgent&) = delete; // cfg_ が df_ を指すことがあるのでコピー禁止
+    RealtimeAgent& operator=(const RealtimeAgent&) = delete;
+
+    RealtimeStep tick(Cell current);
+
+    // ゴールを変えると学習表は捨てる
+    void set_goal(Cell goal);
+    Cell goal() const { return goal_; }
+    void reset_learning();
+
+    size_t learned_cells() const { return learned_; }
+    size_t table_bytes() const { return keys_.capacity() * sizeof(int32_t) + vals_.capacity() * sizeof(uint32_t); }
+
+private:
+    static constexpr uint32_t kDead = ~0u; // ゴールに到達できないと分かったセル
+
+    struct Node {
+        int cell;
+        int parent; // nodes_ 上の添字
+        int64_t g;
+        int64_t h;  // 学習中の値
+        bool closed;
+    };
+    struct HeapItem {
+        int64_t key, g;
+        int idx;
+    };
+
+    int64_t base_h(int cell) const;
+    int64_t h(int cell) const;     // 学習表になければ base_h
+    void learn(int cell, int64_t v);
+    size_t learned_slot(int cell) const;
+    int local(int cell);           // この tick のノード（なければ作る）
+    int find_local(int cell) const;
+
+    const Grid& g_;
+    AstarConfig cfg_;
+    RealtimeConfig rcfg_;
+    Cell goal_;
+    DistanceField df_;             // 膨張を使うときに一度だけ計算した距離場
+    OccupancyCostTable table_;
+    int64_t wmin_ = 1;
+
+    // 学習表（セル -> 学んだ h、開番地法、h は直進 1000 単位の整数）
+    std::vector<int32_t> keys_;
+    std::vector<uint32_t> vals_;
+    size_t learned_ = 0;
+    int shift_ = 60;
+
+    // tick ごとの作業領域（容量は使い回す）
+    std::vector<Node> nodes_;
+    std::vector<HeapItem> heap_;
+    std::vector<int32_t> local_keys_, local_idx_;
+    std::vector<uint32_t> local_stamp_;
+    uint32_t stamp_ = 0;
+    int local_shift_ = 60;
+};
+
+} // namespace engine
@@ -0,0 +1,91 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// クエリの優先度（締切が同じときの順序と、統計の分類に使う）
+enum class QueryPriority { Urgent = 0, Normal, Background };
+inline constexpr int kNumQueryPriorities = 3;
+
+// 非同期に解くクエリ
+struct PlanQuery {
+    const Grid* grid = nullptr; // 結果が出るまで呼び出し側が保持する
+    Cell start{0, 0};
+    Cell goal{0, 0};
+    AstarConfig cfg;            // cfg.cancel を渡せば待機中・実行中のどちらでも中断できる
+};
+
+// 優先度ごとの計測（待ち時間=投入から実行開始まで、実行時間=探索そのもの）
+struct QueryClassStats {
+    uint64_t submitted = 0;
+    uint64_t completed = 0;       // 探索を実行した件数（Cancelled 以外の結果）
+    uint64_t cancelled = 0;       // 中断・締切切れで捨てた件数
+    uint64_t deadline_missed = 0; // 締切を過ぎた件数（遅れて完了したもの、締切で捨てた・打ち切ったもの）
+    double wait_ms_total = 0.0;
+    double wait_ms_max = 0.0;
+    double run_ms_total = 0.0;
+    double run_ms_max = 0.0;
+};
+
+struct SchedulerStats {
+    std::array<QueryClassStats, kNumQueryPriorities> per_class;
+};
+
+struct SchedulerConfig {
+    int num_threads = 0;       // 0以下ならハードウェアのスレッド数
+    bool drop_expired = true;  // 締切を過ぎたクエリは、取り出す時点なら実行せず、実行中なら打ち切って Cancelled
+};
+
+// 締切の早い順（EDF）にワーカープールで astar_plan_ex を実行するスケジューラ
+class PlanScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit PlanScheduler(const SchedulerConfig& cfg = {});
+    ~PlanScheduler(); // 待機中のクエリは Cancelled で完了させ、実行中のものは終わるまで待つ
+    PlanScheduler(const PlanScheduler&) = delete;
+    PlanScheduler& operator=(const PlanScheduler&) = delete;
+
+    std::future<PlanOutcome> submit(const PlanQuery& query, QueryPriority priority, Clock::time_point deadline);
+
+    // 待機中のクエリを全て Cancelled で完了させる（実行中のものは cfg.cancel で止める）
+    void cancel_pending();
+
+    size_t pending() const;
+    SchedulerStats stats() const;
+
+private:
+    struct Job {
+        PlanQuery query;
+        QueryPriority priority;
+        Clock::time_point deadline;
+        Clock::time_point submitted;
+        uint64_t seq; // 同じ締切・優先度なら投入順
+        std::promise<PlanOutcome> promise;
+    };
+    // ヒープの比較（締切 → 優先度 → 投入順 で小さいものが先頭）
+    static bool later(const Job& a, const Job& b);
+
+    void worker();
+    void finish_cancelled(Job& job);
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::vector<Job> heap_;
+    std::vector<std::thread> workers_;
+    SchedulerStats stats_;
+    uint64_t next_seq_ = 0;
+    bool stop_ = false;
+    bool drop_expired_;
+};
+
+} // namespace engine
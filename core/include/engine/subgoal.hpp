@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <optional>
+#include "grid.hpp"
+#include "astar.hpp"
+
+namespace engine {
+
+// サブゴールグラフの構築の計測
+struct SubgoalStats {
+    double build_ms = 0.0;
+    int subgoals = 0; // サブゴール数
+    size_t edges = 0; // 有向辺の数
+    int threads = 0;  // 構築に使ったスレッド数
+};
+
+// Simple Subgoal Graph
+// 障害物の凸な角にサブゴールを置き、直接 h-reachable（ヒューリスティック距離で到達可能）な組を辺で結ぶ
+struct SubgoalGraph {
+    int rows = 0;
+    int cols = 0;
+    bool allow_diagonal = true;
+    int block_threshold = 50;
+    float inflation_cells = 0.0f;       // 構築時の膨張半径 [cell]
+    uint64_t fingerprint = 0;           // 構築元の地図と設定の指紋（読み込み時の照合用）
+    std::vector<Cell> subgoals;
+    std::vector<int32_t> id_of;         // セル -> サブゴールID（なければ-1）
+    std::vector<uint32_t> edge_offsets; // サブゴール -> edges の開始位置（CSR, subgoals+1 要素）
+    std::vector<int32_t> edges;         // 隣接サブゴールID
+    SubgoalStats stats;
+};
+
+// サブゴールごとの辺の計算を並列に行う（num_threads <= 0 ならハードウェアのスレッド数）
+// 対応するのは CostMode::Uniform のみ。グリッド不正や OccupancyWeighted のときは nullopt
+std::optional<SubgoalGraph> build_subgoal_graph(const Grid& g, const AstarConfig& cfg, int num_threads = 0);
+
+// start/goal をグラフに接続してサブゴールグラフ上を探索し、セル列に展開する（最適）
+// 通行可否はグラフ構築時の設定を使う。stats.expanded はグラフ上の展開数
+PlanOutcome subgoal_plan_ex(const SubgoalGraph& sg, const Grid& g, Cell start, Cell goal);
+
+// バイナリ形式での保存/読み込み（マップと並べて置く想定）
+// 読み込みは g が構築時の地図と同じでなければ nullopt（地図を更新したら作り直す）
+bool save_subgoal_graph(const SubgoalGraph& sg, const std::string& path);
+std::optional<SubgoalGraph> load_subgoal_graph(const std::string& path, const Grid& g);
+
+} // namespace engine
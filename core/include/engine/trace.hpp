@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+// 区間イベント（時刻は記録器の生成時点からのナノ秒）
+struct TraceEvent {
+    const char* name; // 文字列リテラルのみ（ポインタをそのまま持つ）
+    const char* cat;
+    int64_t ts_ns;
+    int64_t dur_ns;
+    uint32_t tid;     // 記録したスレッドの連番
+};
+
+// TraceScope の区間を集めるスレッドセーフな記録器
+class TraceRecorder {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    TraceRecorder();
+
+    void add(const char* name, const char* cat, Clock::time_point begin, Clock::time_point end);
+    std::vector<TraceEvent> events() const;
+    void clear();
+
+    // Chrome trace 形式（chrome://tracing / Perfetto で開ける JSON）
+    void write_chrome_json(std::ostream& os) const;
+    bool save_chrome_json(const std::string& path) const;
+
+private:
+    mutable std::mutex mu_;
+    Clock::time_point epoch_;
+    std::vector<TraceEvent> events_;
+};
+
+namespace detail {
+extern std::atomic<TraceRecorder*> g_trace_recorder;
+}
+
+// 全体で使う記録器を設定する（nullptr で無効、既定は無効）
+// 記録中のスコープがある間は記録器を破棄しないこと
+inline void set_trace_recorder(TraceRecorder* rec) {
+    detail::g_trace_recorder.store(rec, std::memory_order_release);
+}
+
+inline TraceRecorder* trace_recorder() {
+    return detail::g_trace_recorder.load(std::memory_order_acquire);
+}
+
+// スコープの開始から終了までを1イベントとして記録する
+// 無効時は原子変数の読み出し1回と分岐だけ（acquire なので記録器の構築結果が見えてから使う）
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, const char* cat = "planner")
+        : rec_(trace_recorder()), name_(name), cat_(cat) {
+        if (rec_) begin_ = TraceRecorder::Clock::now();
+    }
+    ~TraceScope() {
+        if (rec_) rec_->add(name_, cat_, begin_, TraceRecorder::Clock::now());
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    TraceRecorder* rec_;
+    const char* name_;
+    const char* cat_;
+    TraceRecorder::Clock::time_point begin_{};
+};
+
+// HDR 形式の遅延ヒストグラム（ナノ秒、相対誤差 1/128 以下の対数線形バケット）
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record_ns(uint64_t ns);
+    void record(double ms);
+    void merge(const LatencyHistogram& o);
+    void reset();
+
+    uint64_t count() const { return count_; }
+    // q は [0,1]（0.5 で p50、0.999 で p999）。値はバケットの上端を最大値で丸めたもの
+    double percentile(double q) const;
+    double min_ms() const;
+    double max_ms() const;
+    double mean_ms() const;
+
+private:
+    static constexpr int kSubBits = 7;
+    static size_t bucket_of(uint64_t ns);
+    static uint64_t bucket_upper(size_t idx);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t min_ = 0;
+    uint64_t max_ = 0;
+    long double sum_ = 0.0L;
+};
+
+} // namespace engine
@@ -0,0 +1,206 @@
+#include "engine/any_angle.hpp"
+#include "astar_detail.hpp"
+#include "engine/trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+namespace engine {
+
+LineOfSight::LineOfSight(const Grid& g, const AstarConfig& cfg) {
+    TraceScope trace("preprocess");
+    if (detail::validate(g, {0,0}, {0,0}) != PlanStatus::Ok) return;
+    rows_ = g.rows;
+    cols_ = g.cols;
+    words_ = (cols_ + 63) / 64;
+    bits_.assign(static_cast<size_t>(rows_) * words_, 0);
+    detail::Passability pass(g, cfg);
+    for (int r = 0; r < rows_; ++r) {
+        uint64_t* row = bits_.data() + static_cast<size_t>(r) * words_;
+        for (int c = 0; c < cols_; ++c) {
+            if (!pass.blocked(r, c)) row[c >> 6] |= 1ull << (c & 63);
+        }
+    }
+}
+
+bool LineOfSight::free(Cell a) const {
+    if (a.r < 0 || a.c < 0 || a.r >= rows_ || a.c >= cols_) return false;
+    return (bits_[static_cast<size_t>(a.r) * words_ + (a.c >> 6)] >> (a.c & 63)) & 1ull;
+}
+
+bool LineOfSight::row_free(int r, int c0, int c1) const {
+    const uint64_t* row = bits_.data() + static_cast<size_t>(r) * words_;
+    const int w0 = c0 >> 6, w1 = c1 >> 6;
+    for (int w = w0; w <= w1; ++w) {
+        uint64_t mask = ~0ull;
+        if (w == w0) mask &= ~0ull << (c0 & 63);
+        if (w == w1) mask &= ~0ull >> (63 - (c1 & 63));
+        if ((row[w] & mask) != mask) return false;
+    }
+    return true;
+}
+
+// 床関数つきの整数除算（d > 0）
+static inline int64_t floor_div(int64_t n, int64_t d) {
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+bool LineOfSight::visible(Cell a, Cell b) const {
+    if (!free(a) || !free(b)) return false;
+    if (a.r == b.r) return row_free(a.r, std::min(a.c, b.c), std::max(a.c, b.c));
+    if (a.r > b.r) std::swap(a, b);
+
+    // 座標を2倍した整数で扱う（セル (r,c) は [2c,2c+2]x[2r,2r+2]、中心は (2c+1, 2r+1)）
+    const int64_t x0 = 2 * a.c + 1, y0 = 2 * a.r + 1;
+    const int64_t dx = 2 * (b.c - a.c), dy = 2 * (b.r - a.r);
+    for (int r = a.r; r <= b.r; ++r) {
+        // 行 r の帯に入っている区間の両端の x（分母 dy の分数で持つ）
+        const int64_t ya = std::max<int64_t>(y0, 2 * r), yb = std::min<int64_t>(y0 + dy, 2 * r + 2);
+        int64_t na = x0 * dy + (ya - y0) * dx, nb = x0 * dy + (yb - y0) * dx;
+        if (na > nb) std::swap(na, nb);
+        // 閉区間 [2c, 2c+2] が [na/dy, nb/dy] と交わる列
+        int64_t c0 = -floor_div(2 * dy - na, 2 * dy); // ceil((na - 2dy) / 2dy)
+        int64_t c1 = floor_div(nb, 2 * dy);
+        c0 = std::max<int64_t>(c0, 0);
+        c1 = std::min<int64_t>(c1, cols_ - 1);
+        if (!row_free(r, static_cast<int>(c0), static_cast<int>(c1))) return false;
+    }
+    return true;
+}
+
+static inline double dist(Cell a, Cell b) {
+    return std::hypot(static_cast<double>(a.r - b.r), static_cast<double>(a.c - b.c));
+}
+
+double polyline_length(const std::vector<Cell>& path) {
+    double len = 0.0;
+    for (size_t i = 1; i < path.size(); ++i) len += dist(path[i-1], path[i]);
+    return len;
+}
+
+// 隣接セルへの移動（斜めはコーナーカット禁止）
+static inline bool can_step(const LineOfSight& los, int r, int c, int dr, int dc) {
+    if (!los.free({r+dr, c+dc})) return false;
+    if (dr && dc) return los.free({r, c+dc}) && los.free({r+dr, c});
+    return true;
+}
+
+PlanOutcome lazy_theta_plan_ex(const Grid& g, Cell s, Cell t, const AstarConfig& cfg) {
+    PlanOutcome out;
+    out.status = detail::validate(g, s, t);
+    if (out.status != PlanStatus::Ok) return out;
+    if (cfg.cost_mode != CostMode::Uniform) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+    TraceScope trace_query("plan");
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    LineOfSight los(g, cfg);
+    if (!los.free(s) || !los.free(t)) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+
+    TraceScope trace_search("search");
+    const int N = g.rows * g.cols;
+    const int nd = detail::num_dirs(cfg);
+    const double INF = std::numeric_limits<double>::infinity();
+    std::vector<double> gs(N, INF);
+    std::vector<int> parent(N, -1);
+    std::vector<uint8_t> closed(N, 0);
+    auto cell = [&](int id) { return Cell{id / g.cols, id % g.cols}; };
+    auto h = [&](int id) { return dist(cell(id), t); };
+
+    using Item = std::pair<double,int>; // (f, id)
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> open;
+    const int sid = s.r*g.cols + s.c, tid = t.r*g.cols + t.c;
+    gs[sid] = 0.0;
+    parent[sid] = sid;
+    open.push({h(sid), sid});
+
+    PlanResult res;
+    bool found = false;
+    while (!open.empty()) {
+        res.stats.max_open = std::max<int>(res.stats.max_open, static_cast<int>(open.size()));
+        int id = open.top().second; open.pop();
+        if (closed[id]) continue;
+        const Cell cur = cell(id);
+
+        // 親から見えていなければ、確定済みの隣接セルから最良の親を選び直す
+        if (parent[id] != id && !los.visible(cell(parent[id]), cur)) {
+            gs[id] = INF;
+            for (int k = 0; k < nd; ++k) {
+                int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+                int nr = cur.r + dr, nc = cur.c + dc;
+                if (!can_step(los, cur.r, cur.c, dr, dc)) continue;
+                int nid = nr*g.cols + nc;
+                if (!closed[nid]) continue;
+                double cand = gs[nid] + ((dr && dc) ? std::sqrt(2.0) : 1.0);
+                if (cand < gs[id]) { gs[id] = cand; parent[id] = nid; }
+            }
+        }
+        if ((res.stats.expanded & (detail::kCancelCheckInterval - 1)) == 0 && detail::cancel_requested(cfg)) {
+            out.status = PlanStatus::Cancelled;
+            return out;
+        }
+        closed[id] = 1;
+        ++res.stats.expanded;
+        if (id == tid) { found = true; break; }
+
+        // 親からの直線で近傍を評価する（見通しは取り出すときに確かめる）
+        const int pid = parent[id];
+        const Cell pc = cell(pid);
+        for (int k = 0; k < nd; ++k) {
+            int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+            if (!can_step(los, cur.r, cur.c, dr, dc)) continue;
+            int nid = (cur.r+dr)*g.cols + (cur.c+dc);
+            if (closed[nid]) continue;
+            double ng = gs[pid] + dist(pc, cell(nid));
+            if (ng < gs[nid]) {
+                gs[nid] = ng;
+                parent[nid] = pid;
+                open.push({ng + h(nid), nid});
+            }
+        }
+    }
+
+    if (!found) {
+        out.status = PlanStatus::NoPath;
+        return out;
+    }
+    for (int id = tid;; id = parent[id]) {
+        res.path.push_back(cell(id));
+        if (id == sid) break;
+    }
+    std::reverse(res.path.begin(), res.path.end());
+    res.stats.cost = gs[tid];
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    out.status = PlanStatus::Ok;
+    out.result = std::move(res);
+    return out;
+}
+
+std::vector<Cell> smooth_path(const LineOfSight& los, const std::vector<Cell>& path) {
+    if (path.size() <= 2) return path;
+    std::vector<Cell> out;
+    out.push_back(path.front());
+    size_t i = 0;
+    while (i + 1 < path.size()) {
+        size_t j = i + 1;
+        while (j + 1 < path.size() && los.visible(path[i], path[j + 1])) ++j;
+        out.push_back(path[j]);
+        i = j;
+    }
+    return out;
+}
+
+std::vector<Cell> smooth_path(const Grid& g, const AstarConfig& cfg, const std::vector<Cell>& path) {
+    LineOfSight los(g, cfg);
+    return smooth_path(los, path);
+}
+
+} // namespace engine
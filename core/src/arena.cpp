@@ -0,0 +1,75 @@
+#include "engine/arena.hpp"
+#include <algorithm>
+
+namespace engine {
+
+// 最初のチャンクの最小サイズ
+static constexpr size_t kMinChunk = 64 * 1024;
+
+QueryArena::QueryArena(size_t initial_bytes, std::pmr::memory_resource* upstream)
+    : upstream_(upstream ? upstream : std::pmr::new_delete_resource()) {
+    chunks_.reserve(8);
+    if (initial_bytes) add_chunk(initial_bytes);
+}
+
+QueryArena::~QueryArena() {
+    for (const auto& c : chunks_) upstream_->deallocate(c.data, c.size, alignof(std::max_align_t));
+}
+
+void QueryArena::add_chunk(size_t min_bytes) {
+    const size_t last = chunks_.empty() ? 0 : chunks_.back().size;
+    const size_t size = std::max({min_bytes, 2 * last, kMinChunk});
+    char* data = static_cast<char*>(upstream_->allocate(size, alignof(std::max_align_t)));
+    ++upstream_allocs_;
+    chunks_.push_back({data, size});
+    capacity_ += size;
+}
+
+void* QueryArena::do_allocate(size_t bytes, size_t align) {
+    for (;;) {
+        if (cur_ < chunks_.size()) {
+            const Chunk& c = chunks_[cur_];
+            const uintptr_t base = reinterpret_cast<uintptr_t>(c.data);
+            const size_t start = ((base + offset_ + align - 1) & ~(uintptr_t(align) - 1)) - base;
+            if (start + bytes <= c.size) {
+                used_ += start + bytes - offset_;
+                offset_ = start + bytes;
+                return c.data + start;
+            }
+            if (cur_ + 1 < chunks_.size()) { ++cur_; offset_ = 0; continue; }
+        }
+        add_chunk(bytes + align);
+        cur_ = chunks_.size() - 1;
+        offset_ = 0;
+    }
+}
+
+void QueryArena::reset() {
+    // 複数のチャンクに分かれていたら、次から1つで足りるよう合計サイズにまとめ直す
+    if (chunks_.size() > 1) {
+        const size_t total = capacity_;
+        for (const auto& c : chunks_) upstream_->deallocate(c.data, c.size, alignof(std::max_align_t));
+        chunks_.clear();
+        capacity_ = 0;
+        add_chunk(total);
+    }
+    cur_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+void QueryArena::release() {
+    for (const auto& c : chunks_) upstream_->deallocate(c.data, c.size, alignof(std::max_align_t));
+    chunks_.clear();
+    capacity_ = 0;
+    cur_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+QueryArena& thread_query_arena() {
+    thread_local QueryArena arena;
+    return arena;
+}
+
+} // namespace engine
@@ -1,4 +1,7 @@
 #include "engine/astar.hpp"
+#include "astar_detail.hpp"
+#include "radix_heap.hpp"
+#include "engine/trace.hpp"
 #include <queue>
 #include <cmath>
 #include <limits>
@@ -18,8 +21,16 @@ struct Cmp {
     }
 };
 
+OccupancyCostTable default_occupancy_costs() {
+    OccupancyCostTable t{};
+    for (int v = 0; v <= 100; ++v) t[v] = static_cast<uint16_t>(1 + v / 10);
+    return t;
+}
+
+namespace detail {
+
 // ヒューリスティックコスト
-static inline double hcost(int r,int c,int gr,int gc, Heuristic h) {
+double hcost(int r,int c,int gr,int gc, Heuristic h) {
     int dr = std::abs(gr - r), dc = std::abs(gc - c);
     switch (h) {
         case Heuristic::Manhattan: return dr + dc;
@@ -33,57 +44,78 @@ static inline double hcost(int r,int c,int gr,int gc, Heuristic h) {
     return dr + dc;
 }
 
-// s: start, t: target(goal)
-PlanOutcome astar_plan_ex(const Grid& g, Cell s, Cell t, const AstarConfig& cfg) {
-    PlanOutcome out;
-
+PlanStatus validate(const Grid& g, Cell s, Cell t) {
     // グリッドのサイズチェック
-    if (g.rows <= 0 || g.cols <= 0) {
-        out.status = PlanStatus::MapError;
-        return out;
-    }
+    if (g.rows <= 0 || g.cols <= 0) return PlanStatus::MapError;
     const size_t expected = static_cast<size_t>(g.rows) * static_cast<size_t>(g.cols);
-    if (g.occ.size() != expected) {
-        out.status = PlanStatus::MapError;
-        return out;
-    }
+    if (g.occ.size() != expected) return PlanStatus::MapError;
 
     // 範囲外チェック
-    if (!g.in(s.r,s.c) || !g.in(t.r,t.c)){
-        out.status = PlanStatus::OutOfBounds;
-        return out;
+    if (!g.in(s.r,s.c) || !g.in(t.r,t.c)) return PlanStatus::OutOfBounds;
+    return PlanStatus::Ok;
+}
+
+Passability::Passability(const Grid& g, const AstarConfig& cfg, const std::vector<uint8_t>* allowed)
+    : g_(g), threshold_(cfg.block_threshold), allowed_(allowed) {
+    // 障害物の膨張（距離場の距離が半径以下のセルを障害物とみなす）
+    inflation_ = cfg.inflation_radius;
+    if (cfg.inflation_unit == RadiusUnit::Meters && g.resolution > 0.0f) inflation_ /= g.resolution;
+    if (inflation_ > 0.0f) {
+        df_ = cfg.distance_field;
+        if (!df_ || df_->rows != g.rows || df_->cols != g.cols || df_->block_threshold != cfg.block_threshold) {
+            local_df_ = compute_distance_field(g, cfg.block_threshold); // キャッシュがなければ計算
+            df_ = &local_df_;
+        }
     }
+}
 
-    // スタートとゴールが障害物上にないか
-    if (g.at(s.r, s.c) >= cfg.block_threshold ||
-        g.at(t.r, t.c) >= cfg.block_threshold) {
-        out.status = PlanStatus::InvalidArg;
-        return out;
+std::vector<Cell> reconstruct_path(const std::vector<int>& parent, int cols, Cell s, Cell t) {
+    std::vector<Cell> path;
+    int r = t.r, c = t.c;
+    while (!(r==s.r && c==s.c)) {
+        path.push_back({r,c});
+        int p = parent[r*cols + c];
+        if (p < 0) break;
+        r = p / cols; c = p % cols;
     }
+    path.push_back({s.r,s.c});
+    std::reverse(path.begin(), path.end());
+    return path;
+}
 
-    std::optional<PlanResult> result;
+// cfg.memory（なければ既定のヒープ）
+static inline std::pmr::memory_resource* scratch_resource(const AstarConfig& cfg) {
+    return cfg.memory ? cfg.memory : std::pmr::get_default_resource();
+}
 
+// 実数コスト（1 / √2）の A*（見つかれば res に書いて true、見つからなければ fail に理由）
+static bool search_uniform(const Grid& g, Cell s, Cell t, const AstarConfig& cfg,
+                           const Passability& pass, PlanResult& res, PlanStatus& fail) {
     // 時間計測
     auto t0 = std::chrono::high_resolution_clock::now();
     // グリッドのサイズ
     const int N = g.rows * g.cols;
+    // best/parent 配列の分（open list の分は探索中に足す）
+    const size_t fixed = static_cast<size_t>(N) * (sizeof(double) + sizeof(int));
+    if (cfg.memory_budget_bytes && fixed > cfg.memory_budget_bytes) {
+        fail = PlanStatus::ResourceLimit;
+        return false;
+    }
 
     auto idx = [&](int r,int c){ return r*g.cols + c; }; // occでのインデックス
-    auto free_cell = [&](int r,int c){ return g.in(r,c) && g.at(r,c) < cfg.block_threshold; }; // freeかどうか
 
-    std::priority_queue<Node, std::vector<Node>, Cmp> open; // 最小ヒープ
-    std::vector<double> best(N, std::numeric_limits<double>::infinity()); // 各ノードの最小コスト
-    std::vector<int> parent(N, -1); // 各ノードの親
+    std::pmr::memory_resource* mr = scratch_resource(cfg);
+    std::priority_queue<Node, std::pmr::vector<Node>, Cmp> open(Cmp{}, std::pmr::vector<Node>(mr)); // 最小ヒープ
+    std::pmr::vector<double> best(N, std::numeric_limits<double>::infinity(), mr); // 各ノードの最小コスト
+    std::pmr::vector<int> parent(N, -1, mr); // 各ノードの親
 
     Node st{ s.r, s.c, 0.0, hcost(s.r,s.c,t.r,t.c,cfg.heuristic) }; // スタートノード
     open.push(st);
     best[idx(s.r,s.c)] = 0.0;
 
-    std::vector<std::pair<int,int>> dirs = cfg.allow_diagonal
-        ? std::vector<std::pair<int,int>>{{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}}
-        : std::vector<std::pair<int,int>>{{1,0},{-1,0},{0,1},{0,-1}};
-
+    const int nd = num_dirs(cfg);
     int expanded = 0; // 展開したノード数
+    size_t max_open = open.size(); // open listの最大サイズ
 
     while(!open.empty()){
         Node cur = open.top(); open.pop();
@@ -91,32 +123,23 @@ PlanOutcome astar_plan_ex(const Grid& g, Cell s, Cell t, const AstarConfig& cfg)
 
         if (cur.r == t.r && cur.c == t.c) {
             // 経路復元
-            std::vector<Cell> path;
-            int r = cur.r, c = cur.c;
-            while (!(r==s.r && c==s.c)) {
-                path.push_back({r,c});
-                int p = parent[idx(r,c)];
-                if (p < 0) break;
-                r = p / g.cols; c = p % g.cols;
-            }
-            path.push_back({s.r,s.c});
-            std::reverse(path.begin(), path.end());
+            emit_path(res, parent.data(), g.cols, s, t, cfg.path_format);
             auto t1 = std::chrono::high_resolution_clock::now();
             double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
-            result = PlanResult{ std::move(path), {cur.g, expanded, ms} };
-            break;
+            res.stats = {cur.g, expanded, ms, static_cast<int>(max_open), fixed + max_open * sizeof(Node)};
+            return true;
         }
 
+        if ((expanded & (kCancelCheckInterval - 1)) == 0 && cancel_requested(cfg)) {
+            fail = PlanStatus::Cancelled;
+            return false;
+        }
         ++expanded;
-        for (auto [dr,dc] : dirs) {
-            int nr = cur.r + dr, nc = cur.c + dc;
-            if (!free_cell(nr,nc)) continue;
+        for (int k = 0; k < nd; ++k) {
+            int dr = kDirs[k][0], dc = kDirs[k][1];
             // 斜め移動のときはコーナーカットを禁止
-            if (dr && dc) {
-                if (!free_cell(cur.r, nc) || !free_cell(nr, cur.c)) {
-                    continue;
-                }
-            }
+            if (!pass.can_move(cur.r, cur.c, dr, dc)) continue;
+            int nr = cur.r + dr, nc = cur.c + dc;
             double step = (dr && dc) ? std::sqrt(2.0) : 1.0;
             double ng = cur.g + step;
             int id = idx(nr,nc);
@@ -126,17 +149,167 @@ PlanOutcome astar_plan_ex(const Grid& g, Cell s, Cell t, const AstarConfig& cfg)
                 open.push(Node{nr,nc,ng,hcost(nr,nc,t.r,t.c,cfg.heuristic)});
             }
         }
+        max_open = std::max(max_open, open.size());
+        if (cfg.memory_budget_bytes && fixed + max_open * sizeof(Node) > cfg.memory_budget_bytes) {
+            fail = PlanStatus::ResourceLimit;
+            return false;
+        }
+    }
+    fail = PlanStatus::NoPath;
+    return false;
+}
+
+int64_t min_passable_weight(const OccupancyCostTable& table, int block_threshold) {
+    int64_t wmin = std::numeric_limits<int64_t>::max();
+    for (int v = 0; v <= 100 && v < block_threshold; ++v) wmin = std::min<int64_t>(wmin, table[v]);
+    return wmin == std::numeric_limits<int64_t>::max() ? 0 : wmin;
+}
+
+// 占有率で重み付けした整数コストの A*（open list は radix heap）
+static bool search_weighted(const Grid& g, Cell s, Cell t, const AstarConfig& cfg,
+                            const Passability& pass, PlanResult& res, PlanStatus& fail) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const int N = g.rows * g.cols;
+    const size_t fixed = static_cast<size_t>(N) * (sizeof(int64_t) + sizeof(int));
+    constexpr size_t kHeapItem = sizeof(std::pair<uint64_t,int>); // radix heap の1要素
+    if (cfg.memory_budget_bytes && fixed > cfg.memory_budget_bytes) {
+        fail = PlanStatus::ResourceLimit;
+        return false;
+    }
+    const OccupancyCostTable table = cfg.cost_table ? *cfg.cost_table : default_occupancy_costs();
+
+    // 通行可能な占有率での最小倍率（これを掛けたオクタイル距離なら許容的かつ無矛盾）
+    const int64_t wmin = min_passable_weight(table, cfg.block_threshold);
+
+    auto h = [&](int r, int c) -> int64_t {
+        int64_t dr = std::abs(t.r - r), dc = std::abs(t.c - c);
+        if (!cfg.allow_diagonal) return wmin * kStraightCost * (dr + dc);
+        int64_t dmin = std::min(dr, dc), dmax = std::max(dr, dc);
+        return wmin * (kDiagonalCost * dmin + kStraightCost * (dmax - dmin));
+    };
+
+    std::pmr::memory_resource* mr = scratch_resource(cfg);
+    RadixHeap<int> open(mr);
+    std::pmr::vector<int64_t> best(N, std::numeric_limits<int64_t>::max(), mr);
+    std::pmr::vector<int> parent(N, -1, mr);
+
+    const int sid = s.r*g.cols + s.c;
+    best[sid] = 0;
+    open.push(static_cast<uint64_t>(h(s.r, s.c)), sid);
+
+    const int nd = num_dirs(cfg);
+    int expanded = 0;
+    size_t max_open = open.size();
+
+    while (!open.empty()) {
+        auto [f, id] = open.pop();
+        int r = id / g.cols, c = id % g.cols;
+        int64_t gc = best[id];
+        if (static_cast<int64_t>(f) > gc + h(r, c)) continue; // 古いノードをスキップ
+
+        if (r == t.r && c == t.c) {
+            emit_path(res, parent.data(), g.cols, s, t, cfg.path_format);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            double cost = static_cast<double>(gc) / kStraightCost;
+            res.stats = {cost, expanded, ms, static_cast<int>(max_open), fixed + max_open * kHeapItem};
+            return true;
+        }
+
+        if ((expanded & (kCancelCheckInterval - 1)) == 0 && cancel_requested(cfg)) {
+            fail = PlanStatus::Cancelled;
+            return false;
+        }
+        ++expanded;
+        for (int k = 0; k < nd; ++k) {
+            int dr = kDirs[k][0], dc = kDirs[k][1];
+            if (!pass.can_move(r, c, dr, dc)) continue;
+            int nr = r + dr, nc = c + dc;
+            int nid = nr*g.cols + nc;
+            int64_t step = ((dr && dc) ? kDiagonalCost : kStraightCost) * table[std::min<int>(g.at(nr,nc), 100)];
+            int64_t ng = gc + step;
+            if (ng < best[nid]) {
+                best[nid] = ng;
+                parent[nid] = id;
+                open.push(static_cast<uint64_t>(ng + h(nr, nc)), nid);
+            }
+        }
+        max_open = std::max(max_open, open.size());
+        if (cfg.memory_budget_bytes && fixed + max_open * kHeapItem > cfg.memory_budget_bytes) {
+            fail = PlanStatus::ResourceLimit;
+            return false;
+        }
+    }
+    fail = PlanStatus::NoPath;
+    return false;
+}
+
+// s: start, t: target(goal)
+PlanOutcome astar_search(const Grid& g, Cell s, Cell t, const AstarConfig& cfg, const SearchOptions& opt) {
+    TraceScope trace_query("plan");
+    PlanOutcome out;
+    out.status = validate(g, s, t);
+    if (out.status != PlanStatus::Ok) return out;
+
+    // 回廊マスクのサイズチェック
+    if (opt.allowed && opt.allowed->size() != g.occ.size()) {
+        out.status = PlanStatus::MapError;
+        return out;
+    }
+
+    // 前処理（膨張・距離場を含む通行判定の構築）
+    std::optional<TraceScope> trace_pre(std::in_place, "preprocess");
+    Passability pass(g, cfg, opt.allowed);
+    if (opt.free_endpoints) {
+        pass.force_free(s, t);
+    } else if (pass.blocked(s.r, s.c) || pass.blocked(t.r, t.c)) {
+        // スタートとゴールが障害物上にないか
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+    trace_pre.reset();
+
+    TraceScope trace_search("search");
+    PlanStatus fail = PlanStatus::NoPath;
+    std::optional<PlanResult> result;
+    switch (cfg.engine) {
+        case SearchEngine::AStar: {
+            // opt.reuse があればその path / compact の容量を使い回す
+            PlanResult res = opt.reuse ? std::move(*opt.reuse) : PlanResult{};
+            const bool ok = (cfg.cost_mode == CostMode::OccupancyWeighted)
+                ? search_weighted(g, s, t, cfg, pass, res, fail)
+                : search_uniform(g, s, t, cfg, pass, res, fail);
+            if (ok) result = std::move(res);
+            else if (opt.reuse) *opt.reuse = std::move(res);
+            break;
+        }
+        case SearchEngine::Fringe:  result = fringe_search(g, s, t, cfg, pass, fail); break;
+        case SearchEngine::IdaStar: result = ida_search(g, s, t, cfg, pass, fail); break;
     }
-    
+
     if (result.has_value()) {
         out.status = PlanStatus::Ok;
         out.result = std::move(result);
     } else {
-        out.status = PlanStatus::NoPath;
+        out.status = fail;
     }
     return out;
 }
 
+} // namespace detail
+
+PlanOutcome astar_plan_ex(const Grid& g, Cell s, Cell t, const AstarConfig& cfg) {
+    return detail::astar_search(g, s, t, cfg, {});
+}
+
+PlanStatus astar_plan_into(const Grid& g, Cell s, Cell t, const AstarConfig& cfg, PlanResult& out) {
+    detail::SearchOptions opt;
+    opt.reuse = &out;
+    auto res = detail::astar_search(g, s, t, cfg, opt);
+    if (res.result.has_value()) out = std::move(*res.result);
+    return res.status;
+}
+
 std::optional<PlanResult>
 astar_plan(const Grid& g, Cell start, Cell goal, const AstarConfig& cfg) {
     auto out = astar_plan_ex(g, start, goal, cfg);
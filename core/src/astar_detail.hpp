@@ -0,0 +1,98 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "engine/astar.hpp"
+
+// ライブラリ内部専用（公開ヘッダからはincludeしない）
+namespace engine::detail {
+
+// 近傍（先頭4つが上下左右、後ろ4つが斜め）
+inline constexpr int kDirs[8][2] = {{1,0},{-1,0},{0,1},{0,-1},{1,1},{1,-1},{-1,1},{-1,-1}};
+inline int num_dirs(const AstarConfig& cfg) { return cfg.allow_diagonal ? 8 : 4; }
+
+// 中断フラグを見る間隔（展開数、2のべき）
+inline constexpr int kCancelCheckInterval = 256;
+inline bool cancel_requested(const AstarConfig& cfg) {
+    if (cfg.cancel && cfg.cancel->load(std::memory_order_relaxed)) return true;
+    return cfg.deadline != std::chrono::steady_clock::time_point::max() &&
+           std::chrono::steady_clock::now() >= cfg.deadline;
+}
+
+// ヒューリスティックコスト
+double hcost(int r, int c, int gr, int gc, Heuristic h);
+
+// OccupancyWeighted の整数コストの基本単位（直進=1000, 斜め=1414 の固定小数点）
+inline constexpr int64_t kStraightCost = 1000;
+inline constexpr int64_t kDiagonalCost = 1414;
+
+// 通行可能な占有率（< block_threshold）での最小倍率（ヒューリスティックの係数）
+int64_t min_passable_weight(const OccupancyCostTable& table, int block_threshold);
+
+// グリッドと start/goal の範囲チェック（障害物チェックは Passability 側）
+PlanStatus validate(const Grid& g, Cell s, Cell t);
+
+// 通行可否の判定（しきい値・膨張・回廊マスクをまとめたもの）
+class Passability {
+public:
+    Passability(const Grid& g, const AstarConfig& cfg, const std::vector<uint8_t>* allowed = nullptr);
+    Passability(const Passability&) = delete; // local_df_ を指すことがあるのでコピー禁止
+    Passability& operator=(const Passability&) = delete;
+
+    // occ のしきい値と膨張だけを見た障害物判定（範囲内であること）
+    inline bool blocked(int r, int c) const {
+        return g_.at(r,c) >= threshold_ || (df_ && df_->at(r,c) <= inflation_);
+    }
+    // 範囲内・回廊内・障害物でない
+    inline bool free(int r, int c) const {
+        if (!g_.in(r,c)) return false;
+        if (allowed_ && !(*allowed_)[r*g_.cols + c]) return false;
+        if (n_forced_ && is_forced(r,c)) return true;
+        return !blocked(r,c);
+    }
+    // (r,c) から (r+dr,c+dc) へ移動できるか（斜めはコーナーカット禁止）
+    inline bool can_move(int r, int c, int dr, int dc) const {
+        if (!free(r+dr, c+dc)) return false;
+        if (dr && dc) return free(r, c+dc) && free(r+dr, c);
+        return true;
+    }
+    // 障害物上でも通行可とするセル（粗い段の start/goal 用、最大2つ）
+    void force_free(Cell a, Cell b) { forced_[0] = a; forced_[1] = b; n_forced_ = 2; }
+
+private:
+    inline bool is_forced(int r, int c) const {
+        return (forced_[0].r == r && forced_[0].c == c) || (forced_[1].r == r && forced_[1].c == c);
+    }
+    const Grid& g_;
+    int threshold_;
+    float inflation_ = 0.0f;           // [cell]
+    const DistanceField* df_ = nullptr;
+    DistanceField local_df_;           // キャッシュがないときに計算した距離場
+    const std::vector<uint8_t>* allowed_;
+    Cell forced_[2] = {{-1,-1},{-1,-1}};
+    int n_forced_ = 0;
+};
+
+// parent 配列から start→goal のセル列を復元
+std::vector<Cell> reconstruct_path(const std::vector<int>& parent, int cols, Cell s, Cell t);
+
+// format に応じて res.path か res.compact を parent 配列から直接作る
+// res.path / res.compact の容量は使い回す
+void emit_path(PlanResult& res, const int* parent, int cols, Cell s, Cell t, PathFormat format);
+
+// 省メモリの探索エンジン（見つからなければ fail に NoPath / Cancelled / ResourceLimit）
+std::optional<PlanResult> fringe_search(const Grid& g, Cell s, Cell t, const AstarConfig& cfg,
+                                        const Passability& pass, PlanStatus& fail);
+std::optional<PlanResult> ida_search(const Grid& g, Cell s, Cell t, const AstarConfig& cfg,
+                                     const Passability& pass, PlanStatus& fail);
+
+// 探索の追加オプション
+struct SearchOptions {
+    const std::vector<uint8_t>* allowed = nullptr; // 回廊マスク（非0のセルだけ探索、nullptrなら全域）
+    bool free_endpoints = false; // start/goal が障害物上でも通行可として扱う（粗い段の探索用）
+    PlanResult* reuse = nullptr;  // A* の結果を書く前に容量を借りる PlanResult（astar_plan_into 用）
+};
+
+// astar_plan_ex の本体
+PlanOutcome astar_search(const Grid& g, Cell s, Cell t, const AstarConfig& cfg, const SearchOptions& opt);
+
+} // namespace engine::detail
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <vector>
+#include "engine/grid.hpp"
+
+// ライブラリ内部専用（前処理データの保存/読み込み）
+namespace engine::detail {
+
+// 要素数（uint64）+ 生データ
+template <class T>
+void write_vec(std::ofstream& ofs, const std::vector<T>& v) {
+    uint64_t n = v.size();
+    ofs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    ofs.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(n * sizeof(T)));
+}
+
+// max_n を超える要素数は壊れたファイルとして扱う
+template <class T>
+bool read_vec(std::ifstream& ifs, std::vector<T>& v, uint64_t max_n) {
+    uint64_t n = 0;
+    if (!ifs.read(reinterpret_cast<char*>(&n), sizeof(n)) || n > max_n) return false;
+    v.resize(n);
+    return static_cast<bool>(ifs.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(n * sizeof(T))));
+}
+
+// 前処理データの構築元の指紋（地図の大きさと占有率、通行可否を決める設定の FNV-1a）
+// 読み込み時に今の地図と比べ、別の地図や設定で作ったファイルを弾く
+inline uint64_t map_fingerprint(const Grid& g, bool allow_diagonal, int block_threshold, float inflation_cells) {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&h](const void* p, size_t n) {
+        const unsigned char* b = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+    };
+    // コストモードは Uniform 固定（CPD もサブゴールグラフもそれしか作らない）
+    int32_t v[4] = { g.rows, g.cols, allow_diagonal ? 1 : 0, block_threshold };
+    mix(v, sizeof(v));
+    mix(&inflation_cells, sizeof(inflation_cells));
+    mix(g.occ.data(), g.occ.size());
+    return h;
+}
+
+} // namespace engine::detail
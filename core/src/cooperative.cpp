@@ -0,0 +1,325 @@
+#include "engine/cooperative.hpp"
+#include "engine/trace.hpp"
+#include "astar_detail.hpp"
+#include "radix_heap.hpp"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <limits>
+
+namespace engine {
+
+// ---- ReservationTable ----
+
+ReservationTable::ReservationTable(size_t expected) {
+    size_t cap = 16;
+    shift_ = 60;
+    while (cap < expected * 2) { cap <<= 1; --shift_; }
+    keys_.assign(cap, kEmpty);
+    vals_.assign(cap, -1);
+}
+
+// 線形探査（キーだけの配列を走るので1キャッシュラインで8スロット見られる）
+size_t ReservationTable::slot_of(uint64_t k) const {
+    const size_t mask = keys_.size() - 1;
+    size_t i = static_cast<size_t>((k * 0x9E3779B97F4A7C15ull) >> shift_);
+    while (keys_[i] != kEmpty && keys_[i] != k) i = (i + 1) & mask;
+    return i;
+}
+
+void ReservationTable::grow() {
+    std::vector<uint64_t> keys(keys_.size() * 2, kEmpty);
+    std::vector<int32_t> vals(vals_.size() * 2, -1);
+    keys.swap(keys_);
+    vals.swap(vals_);
+    --shift_;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] == kEmpty) continue;
+        const size_t j = slot_of(keys[i]);
+        keys_[j] = keys[i];
+        vals_[j] = vals[i];
+    }
+}
+
+bool ReservationTable::reserve(int cell, int t, int agent) {
+    if ((size_ + 1) * 2 > keys_.size()) grow(); // 負荷率 1/2 以下
+    const uint64_t k = key(cell, t);
+    const size_t i = slot_of(k);
+    if (keys_[i] == k) return false;
+    keys_[i] = k;
+    vals_[i] = agent;
+    ++size_;
+    return true;
+}
+
+int ReservationTable::occupant(int cell, int t) const {
+    const size_t i = slot_of(key(cell, t));
+    return keys_[i] == kEmpty ? -1 : vals_[i];
+}
+
+void ReservationTable::clear() {
+    std::fill(keys_.begin(), keys_.end(), kEmpty);
+    std::fill(vals_.begin(), vals_.end(), -1);
+    size_ = 0;
+}
+
+// ---- 協調探索 ----
+
+namespace {
+
+using detail::kDirs;
+using detail::kStraightCost;
+using detail::kDiagonalCost;
+
+constexpr int64_t kInf = std::numeric_limits<int64_t>::max() / 4;
+
+// 整数コスト（astar.cpp の重み付き探索と同じ。Uniform は倍率1）
+struct StepCost {
+    const Grid& g;
+    bool weighted;
+    OccupancyCostTable table;
+    int64_t wmin;
+
+    int64_t weight(int id) const { return weighted ? table[std::min<int>(g.occ[id], 100)] : 1; }
+    int64_t move(int k, int to) const { return (k < 4 ? kStraightCost : kDiagonalCost) * weight(to); }
+    int64_t wait(int at) const { return kStraightCost * weight(at); }
+};
+
+// ゴールからスタートへ向かう逆向き A*。問い合わせたセルが閉じるまで探索を再開する（RRA*）
+// 閉じたセルの距離はゴールまでの真の距離なので、時空間探索の無矛盾なヒューリスティックになる
+class ReverseResumable {
+public:
+    ReverseResumable(const Grid& g, const detail::Passability& pass, const StepCost& cost, int nd)
+        : g_(g), pass_(pass), cost_(cost), nd_(nd),
+          dist_(static_cast<size_t>(g.rows) * g.cols), seen_(dist_.size(), 0), closed_(dist_.size(), 0) {}
+
+    // 印を進めるので配列を消さずに次の台へ移れる
+    void reset(Cell goal, Cell start) {
+        ++stamp_;
+        open_.clear();
+        start_ = start;
+        const int gid = goal.r*g_.cols + goal.c;
+        dist_[gid] = 0;
+        seen_[gid] = stamp_;
+        open_.push(static_cast<uint64_t>(h(gid)), gid);
+    }
+
+    int64_t distance(int id) {
+        if (closed_[id] == stamp_) return dist_[id];
+        while (!open_.empty()) {
+            const int b = open_.pop().second;
+            if (closed_[b] == stamp_) continue; // 古い要素
+            closed_[b] = stamp_;
+            const int br = b / g_.cols, bc = b % g_.cols;
+            for (int k = 0; k < nd_; ++k) {
+                const int dr = kDirs[k][0], dc = kDirs[k][1];
+                const int ar = br - dr, ac = bc - dc;
+                if (!pass_.free(ar, ac) || !pass_.can_move(ar, ac, dr, dc)) continue;
+                const int a = ar*g_.cols + ac;
+                if (closed_[a] == stamp_) continue;
+                const int64_t nd = dist_[b] + cost_.move(k, b);
+                if (seen_[a] != stamp_ || nd < dist_[a]) {
+                    seen_[a] = stamp_;
+                    dist_[a] = nd;
+                    open_.push(static_cast<uint64_t>(nd + h(a)), a);
+                }
+            }
+            if (b == id) return dist_[b];
+        }
+        return kInf;
+    }
+
+private:
+    int64_t h(int id) const {
+        const int64_t dr = std::abs(id / g_.cols - start_.r), dc = std::abs(id % g_.cols - start_.c);
+        if (nd_ == 4) return cost_.wmin * kStraightCost * (dr + dc);
+        const int64_t dmin = std::min(dr, dc), dmax = std::max(dr, dc);
+        return cost_.wmin * (kDiagonalCost * dmin + kStraightCost * (dmax - dmin));
+    }
+
+    const Grid& g_;
+    const detail::Passability& pass_;
+    const StepCost& cost_;
+    int nd_;
+    Cell start_{0, 0};
+    std::vector<int64_t> dist_;
+    std::vector<uint32_t> seen_, closed_;
+    uint32_t stamp_ = 0;
+    detail::RadixHeap<int> open_;
+};
+
+struct StNode {
+    int cell;
+    int t;
+    int parent; // nodes 上の添字
+    int64_t g;
+};
+
+} // namespace
+
+CooperativeOutcome cooperative_plan_ex(const Grid& g, const std::vector<AgentTask>& tasks,
+                                       const AstarConfig& cfg, const CooperativeConfig& ccfg) {
+    TraceScope trace("cooperative");
+    CooperativeOutcome out;
+    for (const auto& a : tasks) {
+        out.status = detail::validate(g, a.start, a.goal);
+        if (out.status != PlanStatus::Ok) return out;
+    }
+    if (tasks.empty()) {
+        out.status = detail::validate(g, {0,0}, {0,0});
+        if (out.status == PlanStatus::Ok) out.result = CooperativeResult{};
+        return out;
+    }
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    detail::Passability pass(g, cfg);
+    const int N = g.rows * g.cols;
+    std::vector<uint8_t> start_used(N, 0);
+    for (const auto& a : tasks) {
+        const int sid = a.start.r*g.cols + a.start.c;
+        // 障害物上の端点や同じスタートの台は不可
+        if (pass.blocked(a.start.r, a.start.c) || pass.blocked(a.goal.r, a.goal.c) || start_used[sid]) {
+            out.status = PlanStatus::InvalidArg;
+            return out;
+        }
+        start_used[sid] = 1;
+    }
+
+    const bool weighted = cfg.cost_mode == CostMode::OccupancyWeighted;
+    StepCost cost{g, weighted, cfg.cost_table ? *cfg.cost_table : default_occupancy_costs(), 1};
+    if (weighted) cost.wmin = detail::min_passable_weight(cost.table, cfg.block_threshold);
+    const int nd = detail::num_dirs(cfg);
+    const int horizon = ccfg.horizon > 0 ? ccfg.horizon : 4 * (g.rows + g.cols);
+
+    ReservationTable table(tasks.size() * static_cast<size_t>(g.rows + g.cols));
+    std::vector<int> parked(N, INT_MAX); // そのセルに時刻 parked 以降ずっと留まる台がいる
+    std::vector<int> free_after(N, 0);   // そのセルの最後の予約時刻 + 1（ここ以降ならゴールに留まれる）
+    std::vector<char> stuck(tasks.size(), 0); // 失敗が分かっていて最初からスタートに留まる台
+
+    auto occupied = [&](int cell, int t) { return parked[cell] <= t || table.occupant(cell, t) >= 0; };
+    // 時刻 t に to にいた台が t+1 に from へ来るなら、from→to はすれ違いになる
+    auto swaps = [&](int from, int to, int t) {
+        const int o = table.occupant(to, t);
+        return o >= 0 && table.occupant(from, t + 1) == o;
+    };
+
+    CooperativeResult res;
+    ReverseResumable rra(g, pass, cost, nd);
+    ReservationTable visited; // 台ごとの探索で (セル, 時刻) -> nodes の添字
+    std::vector<StNode> nodes;
+    detail::RadixHeap<int> open;
+    int64_t total_expanded = 0;
+
+    // 失敗した台のスタートを先に計画した台が t>0 で通っていたら、その台を最初から留まるものとして
+    // 全員を計画し直す（やり直すたびに stuck が1台以上増えるので tasks.size() 回以内に終わる）
+    for (bool replan = true; replan;) {
+        replan = false;
+        table.clear();
+        std::fill(parked.begin(), parked.end(), INT_MAX);
+        std::fill(free_after.begin(), free_after.end(), 0);
+        res = CooperativeResult{};
+        res.agents.resize(tasks.size());
+        for (size_t a = 0; a < tasks.size(); ++a) {
+            const int sid = tasks[a].start.r*g.cols + tasks[a].start.c;
+            table.reserve(sid, 0, static_cast<int>(a)); // 全員の t=0 の位置
+            if (stuck[a]) parked[sid] = 0;
+        }
+
+        for (size_t a = 0; a < tasks.size() && !replan; ++a) {
+            const Cell s = tasks[a].start, goal = tasks[a].goal;
+            const int sid = s.r*g.cols + s.c, gid = goal.r*g.cols + goal.c;
+            AgentPath& ap = res.agents[a];
+            rra.reset(goal, s);
+            visited.clear();
+            nodes.clear();
+            open.clear();
+
+            int found = -1;
+            // 他の台がゴールに留まり続けるなら到着できない（前の回で失敗した台は探索しない）
+            if (!stuck[a] && parked[gid] == INT_MAX && rra.distance(sid) < kInf) {
+                nodes.push_back({sid, 0, -1, 0});
+                visited.reserve(sid, 0, 0);
+                open.push(static_cast<uint64_t>(rra.distance(sid)), 0);
+            }
+            while (!open.empty()) {
+                auto [f, ni] = open.pop();
+                const StNode n = nodes[ni];
+                if (static_cast<int64_t>(f) > n.g + rra.distance(n.cell)) continue; // 古い要素
+                if (n.cell == gid && n.t >= free_after[gid]) { found = ni; break; }
+
+                if ((total_expanded & (detail::kCancelCheckInterval - 1)) == 0 && detail::cancel_requested(cfg)) {
+                    out.status = PlanStatus::Cancelled;
+                    return out;
+                }
+                ++total_expanded;
+                ++ap.expanded;
+                if (n.t >= horizon) continue;
+
+                const int r = n.cell / g.cols, c = n.cell % g.cols, nt = n.t + 1;
+                for (int k = -1; k < nd; ++k) { // k = -1 は待機
+                    int to = n.cell;
+                    int64_t step = cost.wait(n.cell);
+                    if (k >= 0) {
+                        if (!pass.can_move(r, c, kDirs[k][0], kDirs[k][1])) continue;
+                        to = (r + kDirs[k][0])*g.cols + (c + kDirs[k][1]);
+                        step = cost.move(k, to);
+                    }
+                    if (occupied(to, nt) || (to != n.cell && swaps(n.cell, to, n.t))) continue;
+                    const int64_t h = rra.distance(to);
+                    if (h >= kInf) continue;
+                    const int64_t ng = n.g + step;
+                    int idx = visited.occupant(to, nt);
+                    if (idx < 0) {
+                        idx = static_cast<int>(nodes.size());
+                        nodes.push_back({to, nt, ni, ng});
+                        visited.reserve(to, nt, idx);
+                    } else if (ng < nodes[idx].g) {
+                        nodes[idx].g = ng;
+                        nodes[idx].parent = ni;
+                    } else {
+                        continue;
+                    }
+                    open.push(static_cast<uint64_t>(ng + h), idx);
+                }
+            }
+
+            if (found < 0) {
+                // 動けなかった台はスタートに留まる
+                ap.status = PlanStatus::NoPath;
+                ++res.stats.failed;
+                if (!stuck[a]) {
+                    stuck[a] = 1;
+                    for (size_t b = 0; b < a && !replan; ++b)
+                        for (size_t t = 1; t < res.agents[b].path.size() && !replan; ++t)
+                            replan = res.agents[b].path[t].r == s.r && res.agents[b].path[t].c == s.c;
+                }
+                parked[sid] = 0;
+                continue;
+            }
+            for (int i = found; i >= 0; i = nodes[i].parent) ap.path.push_back({nodes[i].cell / g.cols, nodes[i].cell % g.cols});
+            std::reverse(ap.path.begin(), ap.path.end());
+            ap.cost = static_cast<double>(nodes[found].g) / kStraightCost;
+            ap.status = PlanStatus::Ok;
+            for (int t = 0; t < static_cast<int>(ap.path.size()); ++t) {
+                const int id = ap.path[t].r*g.cols + ap.path[t].c;
+                table.reserve(id, t, static_cast<int>(a));
+                free_after[id] = std::max(free_after[id], t + 1);
+            }
+            parked[gid] = nodes[found].t;
+            ++res.stats.planned;
+            res.stats.makespan = std::max(res.stats.makespan, nodes[found].t);
+        }
+    }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.expanded = total_expanded;
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    res.stats.agents_per_sec = res.stats.time_ms > 0.0 ? tasks.size() * 1000.0 / res.stats.time_ms : 0.0;
+    res.stats.reservations = table.size();
+    res.stats.table_bytes = table.bytes();
+    out.status = res.stats.failed ? PlanStatus::NoPath : PlanStatus::Ok;
+    out.result = std::move(res);
+    return out;
+}
+
+} // namespace engine
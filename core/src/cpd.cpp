@@ -0,0 +1,281 @@
+#include "engine/cpd.hpp"
+#include "astar_detail.hpp"
+#include "binary_io.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <thread>
+
+namespace engine {
+
+static constexpr uint32_t kMoveBits = 4;
+static constexpr uint32_t kMoveMask = (1u << kMoveBits) - 1;
+static constexpr uint8_t kNoMove = 0xF;
+
+static uint64_t fingerprint(const Grid& g, const AstarConfig& cfg) {
+    float inflation = cfg.inflation_radius;
+    if (cfg.inflation_unit == RadiusUnit::Meters && g.resolution > 0.0f) inflation /= g.resolution;
+    return detail::map_fingerprint(g, cfg.allow_diagonal, cfg.block_threshold, inflation);
+}
+
+// 連結成分ごとのDFS前順序（近いセルが近い順位になるので連長圧縮が効く）
+static void order_cells(const Grid& g, const AstarConfig& cfg, const detail::Passability& pass,
+                        std::vector<uint32_t>& rank, std::vector<int32_t>& comp) {
+    const int N = g.rows * g.cols;
+    const int nd = detail::num_dirs(cfg);
+    rank.assign(N, 0);
+    comp.assign(N, -1);
+    uint32_t next = 0;
+    int ncomp = 0;
+    std::vector<int> stack;
+    for (int i = 0; i < N; ++i) {
+        if (comp[i] >= 0 || pass.blocked(i / g.cols, i % g.cols)) continue;
+        comp[i] = ncomp;
+        stack.push_back(i);
+        while (!stack.empty()) {
+            int id = stack.back(); stack.pop_back();
+            rank[id] = next++;
+            int r = id / g.cols, c = id % g.cols;
+            for (int k = nd - 1; k >= 0; --k) {
+                int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+                if (!pass.can_move(r, c, dr, dc)) continue;
+                int nid = (r+dr)*g.cols + (c+dc);
+                if (comp[nid] >= 0) continue;
+                comp[nid] = ncomp;
+                stack.push_back(nid);
+            }
+        }
+        ++ncomp;
+    }
+    // 障害物セルは末尾（参照されない）
+    for (int i = 0; i < N; ++i) if (comp[i] < 0) rank[i] = next++;
+}
+
+std::optional<CompressedPathDb> build_cpd(const Grid& g, const AstarConfig& cfg, int num_threads) {
+    if (detail::validate(g, {0,0}, {0,0}) != PlanStatus::Ok) return std::nullopt;
+    if (cfg.cost_mode != CostMode::Uniform) return std::nullopt;
+    if (static_cast<uint64_t>(g.rows) * g.cols >= (1ull << (32 - kMoveBits))) return std::nullopt; // 順位が入らない
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    CompressedPathDb db;
+    db.rows = g.rows;
+    db.cols = g.cols;
+    db.allow_diagonal = cfg.allow_diagonal;
+    db.block_threshold = cfg.block_threshold;
+    db.fingerprint = fingerprint(g, cfg);
+
+    detail::Passability pass(g, cfg);
+    order_cells(g, cfg, pass, db.rank, db.comp);
+
+    const int N = g.rows * g.cols;
+    std::vector<int> by_rank(N);
+    for (int i = 0; i < N; ++i) by_rank[db.rank[i]] = i;
+
+    if (num_threads <= 0) num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    num_threads = std::max(1, std::min(num_threads, N));
+
+    std::vector<std::vector<uint32_t>> rows_runs(N); // source ごとのラン
+    std::atomic<int> next_source{0};
+    const int nd = detail::num_dirs(cfg);
+
+    auto worker = [&] {
+        std::vector<double> dist(N, std::numeric_limits<double>::infinity());
+        std::vector<uint8_t> first(N, kNoMove);
+        std::vector<int> touched;
+        using Item = std::pair<double,int>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> pq;
+
+        for (int s = next_source++; s < N; s = next_source++) {
+            if (db.comp[s] < 0) continue;
+            // source s からの Dijkstra。最初の一手は親から引き継ぐ
+            dist[s] = 0.0;
+            touched.push_back(s);
+            pq.push({0.0, s});
+            while (!pq.empty()) {
+                auto [d, id] = pq.top(); pq.pop();
+                if (d > dist[id]) continue;
+                int r = id / g.cols, c = id % g.cols;
+                for (int k = 0; k < nd; ++k) {
+                    int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+                    if (!pass.can_move(r, c, dr, dc)) continue;
+                    int nid = (r+dr)*g.cols + (c+dc);
+                    double nd2 = d + ((dr && dc) ? std::sqrt(2.0) : 1.0);
+                    if (nd2 < dist[nid]) {
+                        if (std::isinf(dist[nid])) touched.push_back(nid);
+                        dist[nid] = nd2;
+                        first[nid] = (id == s) ? static_cast<uint8_t>(k) : first[id];
+                        pq.push({nd2, nid});
+                    }
+                }
+            }
+
+            // 順位に沿って連長圧縮。到達不能・自分自身は「どちらでもよい」として前のランに吸収
+            auto& runs = rows_runs[s];
+            uint8_t last = kNoMove;
+            for (int i = 0; i < N; ++i) {
+                int t = by_rank[i];
+                uint8_t m = first[t];
+                if (m == kNoMove || m == last) continue;
+                runs.push_back((static_cast<uint32_t>(i) << kMoveBits) | m);
+                last = m;
+            }
+            if (!runs.empty()) runs.front() &= kMoveMask; // 先頭のランは位置0から
+            runs.shrink_to_fit();
+
+            for (int id : touched) { dist[id] = std::numeric_limits<double>::infinity(); first[id] = kNoMove; }
+            touched.clear();
+        }
+    };
+
+    std::vector<std::thread> th;
+    for (int i = 0; i < num_threads; ++i) th.emplace_back(worker);
+    for (auto& t : th) t.join();
+
+    db.offsets.resize(static_cast<size_t>(N) + 1);
+    size_t total = 0;
+    for (int s = 0; s < N; ++s) { db.offsets[s] = static_cast<uint32_t>(total); total += rows_runs[s].size(); }
+    db.offsets[N] = static_cast<uint32_t>(total);
+    db.runs.reserve(total);
+    for (auto& r : rows_runs) { db.runs.insert(db.runs.end(), r.begin(), r.end()); std::vector<uint32_t>().swap(r); }
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    db.stats.build_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    db.stats.runs = total;
+    db.stats.sources = static_cast<int>(std::count_if(db.comp.begin(), db.comp.end(), [](int32_t c){ return c >= 0; }));
+    db.stats.threads = num_threads;
+    db.stats.bytes = db.rank.size() * sizeof(uint32_t) + db.comp.size() * sizeof(int32_t)
+                   + db.offsets.size() * sizeof(uint32_t) + db.runs.size() * sizeof(uint32_t);
+    return db;
+}
+
+// source s から target の順位 tr への最初の一手（ランを二分探索）
+static uint8_t first_move(const CompressedPathDb& db, int s, uint32_t tr) {
+    auto b = db.runs.begin() + db.offsets[s];
+    auto e = db.runs.begin() + db.offsets[s + 1];
+    if (b == e) return kNoMove;
+    auto it = std::upper_bound(b, e, tr, [](uint32_t v, uint32_t run) { return v < (run >> kMoveBits); });
+    return static_cast<uint8_t>(*std::prev(it) & kMoveMask);
+}
+
+PlanOutcome cpd_plan_ex(const CompressedPathDb& db, Cell s, Cell t) {
+    PlanOutcome out;
+    if (db.rows <= 0 || db.cols <= 0 || db.offsets.size() != static_cast<size_t>(db.rows) * db.cols + 1) {
+        out.status = PlanStatus::MapError;
+        return out;
+    }
+    auto in = [&](Cell c) { return c.r >= 0 && c.c >= 0 && c.r < db.rows && c.c < db.cols; };
+    if (!in(s) || !in(t)) {
+        out.status = PlanStatus::OutOfBounds;
+        return out;
+    }
+    const int sid = s.r*db.cols + s.c, tid = t.r*db.cols + t.c;
+    if (db.comp[sid] < 0 || db.comp[tid] < 0) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+    if (db.comp[sid] != db.comp[tid]) {
+        out.status = PlanStatus::NoPath;
+        return out;
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const uint32_t tr = db.rank[tid];
+    PlanResult res;
+    res.path.push_back(s);
+    double cost = 0.0;
+    Cell cur = s;
+    const int limit = db.rows * db.cols; // 壊れたデータで無限ループしないように
+    while (!(cur.r == t.r && cur.c == t.c)) {
+        uint8_t m = first_move(db, cur.r*db.cols + cur.c, tr);
+        if (m >= 8 || static_cast<int>(res.path.size()) > limit) {
+            out.status = PlanStatus::MapError;
+            return out;
+        }
+        int dr = detail::kDirs[m][0], dc = detail::kDirs[m][1];
+        cur = {cur.r + dr, cur.c + dc};
+        if (!in(cur)) {
+            out.status = PlanStatus::MapError;
+            return out;
+        }
+        cost += (dr && dc) ? std::sqrt(2.0) : 1.0;
+        res.path.push_back(cur);
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.cost = cost;
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    out.status = PlanStatus::Ok;
+    out.result = std::move(res);
+    return out;
+}
+
+static constexpr char kCpdMagic[4] = {'C','P','D','2'};
+
+bool save_cpd(const CompressedPathDb& db, const std::string& path) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) return false;
+    int32_t hdr[4] = { db.rows, db.cols, db.allow_diagonal ? 1 : 0, db.block_threshold };
+    ofs.write(kCpdMagic, sizeof(kCpdMagic));
+    ofs.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+    ofs.write(reinterpret_cast<const char*>(&db.fingerprint), sizeof(db.fingerprint));
+    detail::write_vec(ofs, db.rank);
+    detail::write_vec(ofs, db.comp);
+    detail::write_vec(ofs, db.offsets);
+    detail::write_vec(ofs, db.runs);
+    return static_cast<bool>(ofs);
+}
+
+std::optional<CompressedPathDb> load_cpd(const std::string& path, const Grid& g, const AstarConfig& cfg) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return std::nullopt;
+    char magic[4];
+    int32_t hdr[4];
+    if (!ifs.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, kCpdMagic)) return std::nullopt;
+    if (!ifs.read(reinterpret_cast<char*>(hdr), sizeof(hdr)) || hdr[0] <= 0 || hdr[1] <= 0) return std::nullopt;
+
+    CompressedPathDb db;
+    db.rows = hdr[0];
+    db.cols = hdr[1];
+    db.allow_diagonal = hdr[2] != 0;
+    db.block_threshold = hdr[3];
+    if (!ifs.read(reinterpret_cast<char*>(&db.fingerprint), sizeof(db.fingerprint))) return std::nullopt;
+    // 別の地図・設定で作ったものは使わない（大きさだけ同じでも経路が壁を抜ける）
+    if (db.fingerprint != fingerprint(g, cfg)) return std::nullopt;
+    const uint64_t N = static_cast<uint64_t>(db.rows) * db.cols;
+    if (!detail::read_vec(ifs, db.rank, N) || !detail::read_vec(ifs, db.comp, N) ||
+        !detail::read_vec(ifs, db.offsets, N + 1) || !detail::read_vec(ifs, db.runs, std::numeric_limits<uint32_t>::max()))
+        return std::nullopt;
+    if (db.rank.size() != N || db.comp.size() != N || db.offsets.size() != N + 1 || db.offsets[N] != db.runs.size())
+        return std::nullopt;
+    // 成分ごとのセル数（同じ成分に他のセルがある source はランが1つ以上必要）
+    std::vector<uint32_t> comp_size(N, 0);
+    for (uint64_t i = 0; i < N; ++i) {
+        if (db.rank[i] >= N || db.offsets[i] > db.offsets[i + 1]) return std::nullopt;
+        if (db.comp[i] < -1 || db.comp[i] >= static_cast<int64_t>(N)) return std::nullopt;
+        if (db.comp[i] >= 0) ++comp_size[db.comp[i]];
+    }
+    // first_move の二分探索が範囲外を読まないよう、ランは位置0から始まり位置が増えていくこと
+    for (uint64_t i = 0; i < N; ++i) {
+        const uint32_t b = db.offsets[i], e = db.offsets[i + 1];
+        if (b == e) {
+            if (db.comp[i] >= 0 && comp_size[db.comp[i]] > 1) return std::nullopt;
+            continue;
+        }
+        if ((db.runs[b] >> kMoveBits) != 0) return std::nullopt;
+        for (uint32_t j = b; j < e; ++j) {
+            if ((db.runs[j] & kMoveMask) >= 8) return std::nullopt;
+            if (j > b && (db.runs[j] >> kMoveBits) <= (db.runs[j - 1] >> kMoveBits)) return std::nullopt;
+        }
+    }
+
+    db.stats.runs = db.runs.size();
+    db.stats.sources = static_cast<int>(std::count_if(db.comp.begin(), db.comp.end(), [](int32_t c){ return c >= 0; }));
+    db.stats.bytes = db.rank.size() * sizeof(uint32_t) + db.comp.size() * sizeof(int32_t)
+                   + db.offsets.size() * sizeof(uint32_t) + db.runs.size() * sizeof(uint32_t);
+    return db;
+}
+
+} // namespace engine
@@ -0,0 +1,106 @@
+#include "engine/distance.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace engine {
+
+static constexpr float kFar = 1e20f; // 障害物なし（放物線の計算用に有限値）
+
+// [0, n) を num_threads 個に分けて fn(begin, end) を並列実行
+template <class Fn>
+static void parallel_ranges(int n, int num_threads, Fn fn) {
+    int nt = std::max(1, std::min(num_threads, n));
+    if (nt == 1) { fn(0, n); return; }
+    std::vector<std::thread> th;
+    th.reserve(nt);
+    for (int i = 0; i < nt; ++i) {
+        int b = static_cast<int>(static_cast<long long>(n) * i / nt);
+        int e = static_cast<int>(static_cast<long long>(n) * (i + 1) / nt);
+        th.emplace_back(fn, b, e);
+    }
+    for (auto& t : th) t.join();
+}
+
+// 1次元の2乗距離変換（Felzenszwalb & Huttenlocher の放物線の下側包絡線）
+// f: 入力（2乗距離）, d: 出力, v/z: 作業領域（n, n+1）
+static void edt_1d(const float* f, float* d, int n, int* v, float* z) {
+    int k = 0;
+    v[0] = 0;
+    z[0] = -std::numeric_limits<float>::infinity();
+    z[1] = std::numeric_limits<float>::infinity();
+    auto intersect = [&](int q, int p) {
+        return ((f[q] + float(q) * q) - (f[p] + float(p) * p)) / (2.0f * (q - p));
+    };
+    for (int q = 1; q < n; ++q) {
+        float s = intersect(q, v[k]);
+        while (s <= z[k]) { // z[0] = -inf なので k >= 0 で止まる
+            --k;
+            s = intersect(q, v[k]);
+        }
+        ++k;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<float>::infinity();
+    }
+    k = 0;
+    for (int q = 0; q < n; ++q) {
+        while (z[k + 1] < q) ++k;
+        float dq = float(q - v[k]);
+        d[q] = dq * dq + f[v[k]];
+    }
+}
+
+DistanceField compute_distance_field(const Grid& g, int block_threshold, int num_threads) {
+    DistanceField df;
+    df.rows = g.rows;
+    df.cols = g.cols;
+    df.block_threshold = block_threshold;
+    if (g.rows <= 0 || g.cols <= 0 ||
+        g.occ.size() != static_cast<size_t>(g.rows) * static_cast<size_t>(g.cols)) {
+        df.rows = df.cols = 0;
+        return df;
+    }
+    if (num_threads <= 0) num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    const int R = g.rows, C = g.cols;
+    std::vector<float> col(static_cast<size_t>(R) * C); // 列方向の距離（のちに2乗）
+
+    // パス1: 列ごとの上下スイープ。内側ループは行内の連続した列なのでベクトル化しやすい
+    parallel_ranges(C, num_threads, [&](int c0, int c1) {
+        for (int c = c0; c < c1; ++c) col[c] = (g.occ[c] >= block_threshold) ? 0.0f : kFar;
+        for (int r = 1; r < R; ++r) {
+            const uint8_t* o = &g.occ[static_cast<size_t>(r) * C];
+            float* cur = &col[static_cast<size_t>(r) * C];
+            const float* up = cur - C;
+            for (int c = c0; c < c1; ++c) cur[c] = (o[c] >= block_threshold) ? 0.0f : std::min(up[c] + 1.0f, kFar);
+        }
+        for (int r = R - 2; r >= 0; --r) {
+            float* cur = &col[static_cast<size_t>(r) * C];
+            const float* down = cur + C;
+            for (int c = c0; c < c1; ++c) cur[c] = std::min(cur[c], down[c] + 1.0f);
+        }
+        for (int r = 0; r < R; ++r) {
+            float* cur = &col[static_cast<size_t>(r) * C];
+            for (int c = c0; c < c1; ++c) cur[c] = (cur[c] >= kFar) ? kFar : cur[c] * cur[c];
+        }
+    });
+
+    // パス2: 行ごとの1次元距離変換（行ごとに独立なので行単位で並列化）
+    df.dist.resize(static_cast<size_t>(R) * C);
+    parallel_ranges(R, num_threads, [&](int r0, int r1) {
+        std::vector<int> v(C);
+        std::vector<float> z(C + 1);
+        for (int r = r0; r < r1; ++r) {
+            const float* f = &col[static_cast<size_t>(r) * C];
+            float* d = &df.dist[static_cast<size_t>(r) * C];
+            edt_1d(f, d, C, v.data(), z.data());
+            for (int c = 0; c < C; ++c)
+                d[c] = (d[c] >= kFar * 0.5f) ? std::numeric_limits<float>::infinity() : std::sqrt(d[c]);
+        }
+    });
+    return df;
+}
+
+} // namespace engine
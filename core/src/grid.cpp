@@ -1,4 +1,5 @@
 #include "engine/grid.hpp"
+#include "engine/trace.hpp"
 #include <fstream>
 #include <sstream>
 
@@ -18,6 +19,7 @@ static bool parse_int_token(const std::string& cell, int& out) {
 }
 
 LoadResult load_csv_ex(const std::string& path) {
+    TraceScope trace("load");
     LoadResult out;
 
     std::ifstream ifs(path); // ファイルを開く
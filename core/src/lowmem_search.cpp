@@ -0,0 +1,371 @@
+#include "astar_detail.hpp"
+#include "engine/trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+// 省メモリの探索エンジン（Fringe Search / IDA*）。rows*cols の best/parent 配列もヒープも持たない
+namespace engine::detail {
+
+namespace {
+
+// 移動コストとヒューリスティック（astar.cpp の2つの探索と同じ値になるようにする）
+// OccupancyWeighted では整数コストをそのまま double で持ち、最後に kStraightCost で割る
+struct CostModel {
+    CostModel(const Grid& g, const AstarConfig& cfg, Cell t)
+        : g_(g), weighted_(cfg.cost_mode == CostMode::OccupancyWeighted), diag_(cfg.allow_diagonal),
+          heuristic_(cfg.heuristic), t_(t) {
+        if (weighted_) {
+            table_ = cfg.cost_table ? *cfg.cost_table : default_occupancy_costs();
+            wmin_ = min_passable_weight(table_, cfg.block_threshold);
+        }
+    }
+    double step(int nr, int nc, bool diagonal) const {
+        if (!weighted_) return diagonal ? std::sqrt(2.0) : 1.0;
+        return static_cast<double>((diagonal ? kDiagonalCost : kStraightCost) * table_[std::min<int>(g_.at(nr,nc), 100)]);
+    }
+    double h(int r, int c) const {
+        if (!weighted_) return hcost(r, c, t_.r, t_.c, heuristic_);
+        int64_t dr = std::abs(t_.r - r), dc = std::abs(t_.c - c);
+        if (!diag_) return static_cast<double>(wmin_ * kStraightCost * (dr + dc));
+        int64_t dmin = std::min(dr, dc), dmax = std::max(dr, dc);
+        return static_cast<double>(wmin_ * (kDiagonalCost * dmin + kStraightCost * (dmax - dmin)));
+    }
+    double to_cost(double gv) const { return weighted_ ? gv / kStraightCost : gv; }
+    // 1手の最大コスト（単純経路のコストの上限に使う）
+    double max_step() const {
+        if (!weighted_) return std::sqrt(2.0);
+        return static_cast<double>(kDiagonalCost * *std::max_element(table_.begin(), table_.end()));
+    }
+
+private:
+    const Grid& g_;
+    bool weighted_, diag_;
+    Heuristic heuristic_;
+    Cell t_;
+    OccupancyCostTable table_{};
+    int64_t wmin_ = 0;
+};
+
+inline uint32_t hash_id(int32_t id) {
+    uint32_t x = static_cast<uint32_t>(id);
+    x ^= x >> 16; x *= 0x7feb352du;
+    x ^= x >> 15; x *= 0x846ca68bu;
+    return x ^ (x >> 16);
+}
+
+// 予算内で v に1要素追加できるよう確保する（extra_bytes は v 以外の使用量）
+template <class T>
+bool reserve_room(std::vector<T>& v, size_t extra_bytes, size_t budget) {
+    if (v.size() < v.capacity()) return true;
+    size_t cap = std::max<size_t>(16, v.capacity() * 2);
+    if (budget) {
+        const size_t used = extra_bytes + v.capacity() * sizeof(T);
+        if (used >= budget) return false;
+        cap = std::min(cap, v.capacity() + (budget - used) / sizeof(T));
+        if (cap <= v.size()) return false;
+    }
+    v.reserve(cap);
+    return true;
+}
+
+// 経路の出力（path_format に合わせる）
+void finish_path(PlanResult& res, std::vector<Cell>&& path, PathFormat format) {
+    TraceScope trace("reconstruct");
+    if (format == PathFormat::Cells) {
+        res.path = std::move(path);
+    } else {
+        res.compact = encode_path(path, format);
+    }
+}
+
+} // namespace
+
+// ---- Fringe Search ----
+// now/later の2本のリストで f 閾値を上げながら探索する。g と親の方向は訪問したセルだけを
+// 開番地法のハッシュ表に持ち、訪問済みかどうかはビットマップで引く（未訪問なら表を引かない）
+std::optional<PlanResult> fringe_search(const Grid& g, Cell s, Cell t, const AstarConfig& cfg,
+                                        const Passability& pass, PlanStatus& fail) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const int N = g.rows * g.cols;
+    const size_t budget = cfg.memory_budget_bytes;
+    const CostModel cm(g, cfg, t);
+    const int nd = num_dirs(cfg);
+
+    struct Slot { int32_t id; uint8_t dir; double g; };
+    std::vector<uint64_t> visited((static_cast<size_t>(N) + 63) / 64, 0);
+    std::vector<uint64_t> in_fringe(visited.size(), 0);
+    std::vector<Slot> table;
+    std::vector<int32_t> now, later;
+    size_t used_slots = 0, peak = 0;
+
+    auto bit = [](const std::vector<uint64_t>& b, int id) { return (b[id >> 6] >> (id & 63)) & 1ull; };
+    auto set_bit = [](std::vector<uint64_t>& b, int id, bool v) {
+        if (v) b[id >> 6] |= 1ull << (id & 63); else b[id >> 6] &= ~(1ull << (id & 63));
+    };
+    auto bytes = [&] {
+        return (visited.size() + in_fringe.size()) * sizeof(uint64_t) + table.capacity() * sizeof(Slot)
+             + (now.capacity() + later.capacity()) * sizeof(int32_t);
+    };
+    auto find_slot = [&](int32_t id) -> Slot& {
+        const size_t mask = table.size() - 1;
+        size_t i = hash_id(id) & mask;
+        while (table[i].id != id && table[i].id != -1) i = (i + 1) & mask;
+        return table[i];
+    };
+    // 負荷率 1/2 を超えたら倍にする（予算を超えるなら false）
+    auto grow_table = [&]() -> bool {
+        if ((used_slots + 1) * 2 <= table.size()) return true;
+        const size_t cap = std::max<size_t>(64, table.size() * 2);
+        if (budget && bytes() + cap * sizeof(Slot) > budget) return false; // 移し替えの間は新旧両方を持つ
+        std::vector<Slot> old(cap, Slot{-1, 0, 0.0});
+        old.swap(table);
+        for (const Slot& e : old) if (e.id != -1) find_slot(e.id) = e;
+        peak = std::max(peak, bytes() + old.capacity() * sizeof(Slot));
+        return true;
+    };
+
+    if (budget && bytes() > budget) { fail = PlanStatus::ResourceLimit; return std::nullopt; }
+    const int sid = s.r*g.cols + s.c, tid = t.r*g.cols + t.c;
+    if (!grow_table()) { fail = PlanStatus::ResourceLimit; return std::nullopt; }
+    find_slot(sid) = Slot{sid, 0xFF, 0.0};
+    ++used_slots;
+    set_bit(visited, sid, true);
+    set_bit(in_fringe, sid, true);
+    now.push_back(sid);
+
+    double flimit = cm.h(s.r, s.c);
+    int expanded = 0;
+    size_t max_open = 1;
+    bool found = false;
+    while (!found) {
+        double fmin = std::numeric_limits<double>::infinity();
+        while (!now.empty()) {
+            const int id = now.back(); now.pop_back();
+            if (!bit(in_fringe, id)) continue; // 改善されて別の位置から展開済み
+            const int r = id / g.cols, c = id % g.cols;
+            const double gv = find_slot(id).g;
+            const double f = gv + cm.h(r, c);
+            if (f > flimit) {
+                fmin = std::min(fmin, f);
+                if (!reserve_room(later, bytes() - later.capacity() * sizeof(int32_t), budget)) {
+                    fail = PlanStatus::ResourceLimit;
+                    return std::nullopt;
+                }
+                later.push_back(id);
+                continue;
+            }
+            if (id == tid) { found = true; break; }
+            if ((expanded & (kCancelCheckInterval - 1)) == 0 && cancel_requested(cfg)) {
+                fail = PlanStatus::Cancelled;
+                return std::nullopt;
+            }
+            ++expanded;
+            set_bit(in_fringe, id, false);
+
+            // 子は now の末尾に積んで、この反復のうちに続けて調べる
+            for (int k = nd - 1; k >= 0; --k) {
+                int dr = kDirs[k][0], dc = kDirs[k][1];
+                if (!pass.can_move(r, c, dr, dc)) continue;
+                const int nr = r + dr, nc = c + dc, nid = nr*g.cols + nc;
+                const double ng = gv + cm.step(nr, nc, dr && dc);
+                if (bit(visited, nid)) {
+                    Slot& e = find_slot(nid);
+                    if (ng >= e.g) continue;
+                    e.g = ng;
+                    e.dir = static_cast<uint8_t>(k);
+                } else {
+                    if (!grow_table()) { fail = PlanStatus::ResourceLimit; return std::nullopt; }
+                    find_slot(nid) = Slot{nid, static_cast<uint8_t>(k), ng};
+                    ++used_slots;
+                    set_bit(visited, nid, true);
+                }
+                if (!reserve_room(now, bytes() - now.capacity() * sizeof(int32_t), budget)) {
+                    fail = PlanStatus::ResourceLimit;
+                    return std::nullopt;
+                }
+                set_bit(in_fringe, nid, true);
+                now.push_back(nid);
+            }
+            max_open = std::max(max_open, now.size() + later.size());
+            peak = std::max(peak, bytes());
+        }
+        if (found) break;
+        if (later.empty()) { fail = PlanStatus::NoPath; return std::nullopt; }
+        now.swap(later);
+        std::reverse(now.begin(), now.end()); // 元の順（先に入れたものから）で調べる
+        flimit = fmin;
+    }
+
+    // 親の方向をたどって復元
+    std::vector<Cell> path;
+    for (int id = tid;;) {
+        path.push_back({id / g.cols, id % g.cols});
+        if (id == sid) break;
+        const Slot& e = find_slot(id);
+        id -= kDirs[e.dir][0] * g.cols + kDirs[e.dir][1];
+    }
+    std::reverse(path.begin(), path.end());
+
+    PlanResult res;
+    finish_path(res, std::move(path), cfg.path_format);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.cost = cm.to_cost(find_slot(tid).g);
+    res.stats.expanded = expanded;
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    res.stats.max_open = static_cast<int>(max_open);
+    res.stats.peak_bytes = std::max(peak, bytes());
+    return res;
+}
+
+// s から t に行けるか（通れるセルのビットマップ2枚だけで塗りつぶす）
+// pending のビットを前から順に処理し、後ろに立ったビットは同じ走査で、前に立ったビットは次の走査で拾う
+PlanStatus flood_reachable(const Grid& g, const AstarConfig& cfg, const Passability& pass,
+                           int sid, int tid, size_t& peak) {
+    const int N = g.rows * g.cols;
+    const int nd = num_dirs(cfg);
+    const size_t words = (static_cast<size_t>(N) + 63) / 64;
+    if (cfg.memory_budget_bytes && 2 * words * sizeof(uint64_t) > cfg.memory_budget_bytes) return PlanStatus::ResourceLimit;
+    std::vector<uint64_t> reached(words, 0), pending(words, 0);
+    peak = std::max(peak, 2 * words * sizeof(uint64_t));
+    reached[sid >> 6] |= 1ull << (sid & 63);
+    pending[sid >> 6] |= 1ull << (sid & 63);
+    for (bool more = true; more;) {
+        more = false;
+        if (cancel_requested(cfg)) return PlanStatus::Cancelled;
+        for (size_t w = 0; w < words; ++w) {
+            while (pending[w]) {
+                const int id = static_cast<int>(w * 64) + __builtin_ctzll(pending[w]);
+                pending[w] &= pending[w] - 1;
+                if (id == tid) return PlanStatus::Ok;
+                const int r = id / g.cols, c = id % g.cols;
+                for (int k = 0; k < nd; ++k) {
+                    if (!pass.can_move(r, c, kDirs[k][0], kDirs[k][1])) continue;
+                    const int nid = (r + kDirs[k][0])*g.cols + (c + kDirs[k][1]);
+                    const uint64_t b = 1ull << (nid & 63);
+                    if (reached[nid >> 6] & b) continue;
+                    reached[nid >> 6] |= b;
+                    pending[nid >> 6] |= b;
+                    more |= static_cast<size_t>(nid >> 6) < w;
+                }
+            }
+        }
+    }
+    return PlanStatus::NoPath;
+}
+
+// ---- IDA* ----
+// 深さ優先の反復深化。置換表（セル -> 最良の g）は予算の半分に収まる固定サイズで、
+// 衝突したら古い反復の項目から上書きする。表が小さいほど同じセルを何度も展開する
+std::optional<PlanResult> ida_search(const Grid& g, Cell s, Cell t, const AstarConfig& cfg,
+                                     const Passability& pass, PlanStatus& fail) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const int N = g.rows * g.cols;
+    const size_t budget = cfg.memory_budget_bytes;
+    const CostModel cm(g, cfg, t);
+    const int nd = num_dirs(cfg);
+
+    const int sid = s.r*g.cols + s.c, tid = t.r*g.cols + t.c;
+    // 閾値を少しずつ上げる反復は到達できないと分かるまで指数的に時間がかかるので、先に到達可能性を調べる
+    // （塗りつぶしのビットマップは置換表を確保する前に解放する）
+    size_t flood_bytes = 0;
+    {
+        const PlanStatus st = flood_reachable(g, cfg, pass, sid, tid, flood_bytes);
+        if (st != PlanStatus::Ok) { fail = st; return std::nullopt; }
+    }
+
+    struct TtSlot { int32_t id; uint32_t iter; double g; };
+    struct Frame { int32_t id; uint8_t next; double g; };
+    constexpr int kProbe = 4;
+
+    // 置換表の大きさ（2のべき）。予算がなければセル数の2倍（上限 2^16 = 1MiB）
+    size_t tt_cap = 1;
+    const size_t tt_target = budget ? budget / 2 / sizeof(TtSlot) : std::min<size_t>(2 * static_cast<size_t>(N), size_t(1) << 16);
+    while (tt_cap * 2 <= tt_target) tt_cap *= 2;
+    if (tt_cap < kProbe) { fail = PlanStatus::ResourceLimit; return std::nullopt; }
+    std::vector<TtSlot> tt(tt_cap, TtSlot{-1, 0, 0.0});
+    const size_t tt_bytes = tt_cap * sizeof(TtSlot);
+    std::vector<Frame> stack;
+    size_t peak = std::max(tt_bytes, flood_bytes);
+
+    // 枝刈りするなら true。しないなら g を記録する
+    auto tt_prune = [&](int32_t id, double gv, uint32_t iter) {
+        const size_t mask = tt_cap - 1;
+        const size_t h0 = hash_id(id) & mask;
+        size_t victim = h0;
+        for (int p = 0; p < kProbe; ++p) {
+            TtSlot& e = tt[(h0 + p) & mask];
+            if (e.id == id) {
+                if (gv > e.g || (gv == e.g && e.iter == iter)) return true;
+                e.g = gv; e.iter = iter;
+                return false;
+            }
+            if (e.id == -1) { e = TtSlot{id, iter, gv}; return false; }
+            if (e.iter < tt[victim].iter) victim = (h0 + p) & mask;
+        }
+        tt[victim] = TtSlot{id, iter, gv};
+        return false;
+    };
+
+    // 最適経路は単純経路なので、閾値がこれを超えたら経路はない（置換表から溢れて閉路を辿る場合の打ち切り）
+    const double max_bound = static_cast<double>(N) * cm.max_step();
+    double bound = cm.h(s.r, s.c);
+    int expanded = 0;
+    size_t max_depth = 0;
+    for (uint32_t iter = 1;; ++iter) {
+        double next_bound = std::numeric_limits<double>::infinity();
+        stack.clear();
+        stack.push_back({sid, 0, 0.0});
+        tt_prune(sid, 0.0, iter);
+        while (!stack.empty()) {
+            Frame& f = stack.back();
+            const int r = f.id / g.cols, c = f.id % g.cols;
+            if (f.next == 0) {
+                const double fv = f.g + cm.h(r, c);
+                if (fv > bound) {
+                    next_bound = std::min(next_bound, fv);
+                    stack.pop_back();
+                    continue;
+                }
+                if (f.id == tid) break;
+                if ((expanded & (kCancelCheckInterval - 1)) == 0 && cancel_requested(cfg)) {
+                    fail = PlanStatus::Cancelled;
+                    return std::nullopt;
+                }
+                ++expanded;
+            }
+            if (f.next >= nd) { stack.pop_back(); continue; }
+            const int k = f.next++;
+            const int dr = kDirs[k][0], dc = kDirs[k][1];
+            if (!pass.can_move(r, c, dr, dc)) continue;
+            const int nr = r + dr, nc = c + dc, nid = nr*g.cols + nc;
+            if (stack.size() >= 2 && stack[stack.size() - 2].id == nid) continue; // すぐ親に戻らない
+            const double ng = f.g + cm.step(nr, nc, dr && dc);
+            if (tt_prune(nid, ng, iter)) continue;
+            if (!reserve_room(stack, tt_bytes, budget)) { fail = PlanStatus::ResourceLimit; return std::nullopt; }
+            stack.push_back({nid, 0, ng}); // f は無効になる
+            max_depth = std::max(max_depth, stack.size());
+            peak = std::max(peak, tt_bytes + stack.capacity() * sizeof(Frame));
+        }
+        if (!stack.empty()) break; // ゴールに到達
+        if (std::isinf(next_bound) || next_bound > max_bound) { fail = PlanStatus::NoPath; return std::nullopt; }
+        bound = next_bound;
+    }
+
+    std::vector<Cell> path;
+    path.reserve(stack.size());
+    for (const Frame& f : stack) path.push_back({f.id / g.cols, f.id % g.cols});
+
+    PlanResult res;
+    finish_path(res, std::move(path), cfg.path_format);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.cost = cm.to_cost(stack.back().g);
+    res.stats.expanded = expanded;
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    res.stats.max_open = static_cast<int>(max_depth);
+    res.stats.peak_bytes = peak;
+    return res;
+}
+
+} // namespace engine::detail
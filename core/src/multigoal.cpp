@@ -0,0 +1,271 @@
+#include "engine/multigoal.hpp"
+#include "astar_detail.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+namespace engine {
+
+// これより多いゴールは空間バケットに分ける（1バケットあたりのゴール数の目安の下限も兼ねる）
+static constexpr int kBucketThreshold = 32;
+
+// ゴールの広がりと数から、1バケットに max(32, √n) 個ほど入る一辺を選ぶ
+// （一様に散らばっていれば、下界の計算とバケット内の走査がどちらも O(√n) 程度になる。
+//   偏りが強いと空のバケットが出ないかわりに1バケットのゴールが増え、枝刈りの効きは落ちる）
+static int auto_bucket_size(const std::vector<Cell>& goals) {
+    int r0 = goals[0].r, r1 = r0, c0 = goals[0].c, c1 = c0;
+    for (const auto& t : goals) {
+        r0 = std::min(r0, t.r); r1 = std::max(r1, t.r);
+        c0 = std::min(c0, t.c); c1 = std::max(c1, t.c);
+    }
+    const double n = static_cast<double>(goals.size());
+    const double per_bucket = std::max<double>(kBucketThreshold, std::sqrt(n));
+    const double buckets = std::max(1.0, n / per_bucket);
+    const double area = static_cast<double>(r1 - r0 + 1) * (c1 - c0 + 1);
+    return std::max(4, static_cast<int>(std::ceil(std::sqrt(area / buckets))));
+}
+
+GoalSet::GoalSet(const std::vector<Cell>& goals, int bucket_size) {
+    const int n = static_cast<int>(goals.size());
+    if (bucket_size == 0 && n > kBucketThreshold) bucket_size = auto_bucket_size(goals);
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    auto bkey = [&](const Cell& c) {
+        return std::make_pair(c.r / bucket_size, c.c / bucket_size);
+    };
+    if (bucket_size > 0) {
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return bkey(goals[a]) < bkey(goals[b]); });
+    }
+
+    rows_.reserve(n);
+    cols_.reserve(n);
+    for (int i : order) {
+        rows_.push_back(static_cast<float>(goals[i].r));
+        cols_.push_back(static_cast<float>(goals[i].c));
+    }
+    if (bucket_size <= 0) return;
+
+    // 同じバケットの連続区間ごとにバウンディングボックスを作る
+    for (int i = 0; i < n;) {
+        int j = i;
+        auto k = bkey(goals[order[i]]);
+        float r0 = rows_[i], r1 = rows_[i], c0 = cols_[i], c1 = cols_[i];
+        while (j < n && bkey(goals[order[j]]) == k) {
+            r0 = std::min(r0, rows_[j]); r1 = std::max(r1, rows_[j]);
+            c0 = std::min(c0, cols_[j]); c1 = std::max(c1, cols_[j]);
+            ++j;
+        }
+        b_r0_.push_back(r0); b_r1_.push_back(r1);
+        b_c0_.push_back(c0); b_c1_.push_back(c1);
+        b_begin_.push_back(i);
+        b_end_.push_back(j);
+        i = j;
+    }
+}
+
+// ---- [0, n) のゴールに対する最小値（平方根を取る前の値） ----
+// 浮動小数の min の畳み込みは -ffinite-math-only なしではコンパイラが自動でベクトル化しないので、
+// SSE2（x86-64 では常に使える）で4レーンずつ明示的に計算し、端数と他のアーキテクチャはスカラーで計算する
+template <Heuristic H>
+static inline float metric(float dr, float dc, float k) {
+    dr = std::fabs(dr); dc = std::fabs(dc);
+    if (H == Heuristic::Manhattan) return dr + dc;
+    if (H == Heuristic::Euclidean) return dr * dr + dc * dc;
+    return std::max(dr, dc) + k * std::min(dr, dc);
+}
+
+template <Heuristic H>
+static float min_metric(const float* gr, const float* gc, int n, float fr, float fc, float k) {
+    float best = std::numeric_limits<float>::infinity();
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 vr = _mm_set1_ps(fr), vc = _mm_set1_ps(fc), vk = _mm_set1_ps(k);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vbest = _mm_set1_ps(best);
+    for (; i + 4 <= n; i += 4) {
+        const __m128 dr = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(gr + i), vr), abs_mask);
+        const __m128 dc = _mm_and_ps(_mm_sub_ps(_mm_loadu_ps(gc + i), vc), abs_mask);
+        __m128 v;
+        if (H == Heuristic::Manhattan) v = _mm_add_ps(dr, dc);
+        else if (H == Heuristic::Euclidean) v = _mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dc, dc));
+        else v = _mm_add_ps(_mm_max_ps(dr, dc), _mm_mul_ps(vk, _mm_min_ps(dr, dc)));
+        vbest = _mm_min_ps(vbest, v);
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, vbest);
+    best = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+#endif
+    for (; i < n; ++i) best = std::min(best, metric<H>(gr[i] - fr, gc[i] - fc, k));
+    return best;
+}
+
+// [begin, end) のゴールに対する最小値
+double GoalSet::scan(int r, int c, Heuristic h, double octile_k, int begin, int end) const {
+    const float fr = static_cast<float>(r), fc = static_cast<float>(c), k = static_cast<float>(octile_k);
+    const float* gr = rows_.data() + begin;
+    const float* gc = cols_.data() + begin;
+    const int n = end - begin;
+    switch (h) {
+        case Heuristic::Manhattan: return min_metric<Heuristic::Manhattan>(gr, gc, n, fr, fc, k);
+        case Heuristic::Euclidean: return std::sqrt(static_cast<double>(min_metric<Heuristic::Euclidean>(gr, gc, n, fr, fc, k)));
+        case Heuristic::Octile: break;
+    }
+    return min_metric<Heuristic::Octile>(gr, gc, n, fr, fc, k);
+}
+
+double GoalSet::min_heuristic(int r, int c, Heuristic h, double octile_k, const std::atomic<bool>* cancel) const {
+    double best;
+    if (b_begin_.empty()) {
+        best = scan(r, c, h, octile_k, 0, size());
+    } else {
+        // バケットの下界（ボックスまでの距離）を一度だけ計算し、下界の小さいバケットから調べて枝刈り
+        const int nb = static_cast<int>(b_begin_.size());
+        const float fr = static_cast<float>(r), fc = static_cast<float>(c);
+        thread_local std::vector<double> lbs;
+        lbs.resize(nb);
+        int first = 0;
+        for (int b = 0; b < nb; ++b) {
+            const float dr = std::max({b_r0_[b] - fr, fr - b_r1_[b], 0.0f});
+            const float dc = std::max({b_c0_[b] - fc, fc - b_c1_[b], 0.0f});
+            switch (h) {
+                case Heuristic::Manhattan: lbs[b] = dr + dc; break;
+                case Heuristic::Euclidean: lbs[b] = std::sqrt(static_cast<double>(dr * dr + dc * dc)); break;
+                case Heuristic::Octile: lbs[b] = std::max(dr, dc) + octile_k * std::min(dr, dc); break;
+            }
+            if (lbs[b] < lbs[first]) first = b;
+        }
+        best = scan(r, c, h, octile_k, b_begin_[first], b_end_[first]);
+        for (int b = 0; b < nb; ++b) {
+            if (b == first || lbs[b] >= best) continue;
+            // 中断されたら 0（許容的な下界）を返し、探索側の中断判定に任せる
+            if (cancel && cancel->load(std::memory_order_relaxed)) return 0.0;
+            best = std::min(best, scan(r, c, h, octile_k, b_begin_[b], b_end_[b]));
+        }
+    }
+    // float の丸めで実距離を超えないように僅かに小さくする（許容性の維持）
+    return best * (1.0 - 1e-6);
+}
+
+namespace {
+struct Node { int id; double g, f; };
+struct Cmp {
+    bool operator()(const Node& a, const Node& b) const {
+        if (a.f != b.f) return a.f > b.f; // f が小さいほど優先
+        return a.g < b.g;                 // 同じ f なら g が大きい（ゴールに近い）ほど優先
+    }
+};
+} // namespace
+
+MultiGoalOutcome astar_plan_multi_ex(const Grid& g, Cell s, const std::vector<Cell>& goals,
+                                     const AstarConfig& cfg) {
+    MultiGoalOutcome out;
+    if (goals.empty()) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+    out.status = detail::validate(g, s, s);
+    if (out.status != PlanStatus::Ok) return out;
+    for (const auto& t : goals) {
+        if (!g.in(t.r, t.c)) {
+            out.status = PlanStatus::OutOfBounds;
+            return out;
+        }
+    }
+
+    detail::Passability pass(g, cfg);
+    if (pass.blocked(s.r, s.c)) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+
+    // 使えるゴール（障害物上を除く、重複は先のものを採用）
+    std::unordered_map<int, int> goal_of; // セル -> goals の添字
+    std::vector<Cell> usable;
+    for (int i = 0; i < static_cast<int>(goals.size()); ++i) {
+        const auto& t = goals[i];
+        if (pass.blocked(t.r, t.c)) continue;
+        if (goal_of.emplace(t.r*g.cols + t.c, i).second) usable.push_back(t);
+    }
+    if (usable.empty()) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    GoalSet gs(usable);
+
+    // コスト（OccupancyWeighted は単一ゴールと同じ 1.000/1.414 × 倍率）
+    const bool weighted = (cfg.cost_mode == CostMode::OccupancyWeighted);
+    const OccupancyCostTable table = (weighted && cfg.cost_table) ? *cfg.cost_table : default_occupancy_costs();
+    const double diag = weighted ? double(detail::kDiagonalCost) / detail::kStraightCost : std::sqrt(2.0);
+    const double hscale = weighted ? static_cast<double>(detail::min_passable_weight(table, cfg.block_threshold)) : 1.0;
+    const Heuristic heur = weighted ? (cfg.allow_diagonal ? Heuristic::Octile : Heuristic::Manhattan) : cfg.heuristic;
+    // 重み付きの斜めは 1.414 なので、Octile の斜めの追加分も √2-1 ではなく 0.414 にする（過大評価しない）
+    const double octile_k = weighted ? diag - 1.0 : GoalSet::kOctileK;
+    auto h = [&](int r, int c) { return hscale * gs.min_heuristic(r, c, heur, octile_k, cfg.cancel); };
+
+    const int N = g.rows * g.cols;
+    std::priority_queue<Node, std::vector<Node>, Cmp> open;
+    std::vector<double> best(N, std::numeric_limits<double>::infinity());
+    std::vector<int> parent(N, -1);
+
+    const int sid = s.r*g.cols + s.c;
+    best[sid] = 0.0;
+    open.push({sid, 0.0, h(s.r, s.c)});
+
+    const int nd = detail::num_dirs(cfg);
+    int expanded = 0;
+    size_t max_open = open.size();
+
+    while (!open.empty()) {
+        Node cur = open.top(); open.pop();
+        if (cur.g > best[cur.id]) continue; // 古いノードをスキップ
+        int r = cur.id / g.cols, c = cur.id % g.cols;
+
+        auto it = goal_of.find(cur.id);
+        if (it != goal_of.end()) {
+            Cell t = goals[it->second];
+            auto path = detail::reconstruct_path(parent, g.cols, s, t);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            out.status = PlanStatus::Ok;
+            out.result = PlanResult{ std::move(path), {cur.g, expanded, ms, static_cast<int>(max_open),
+                                    static_cast<size_t>(N) * (sizeof(double) + sizeof(int)) + max_open * sizeof(Node)}, std::nullopt };
+            out.goal_index = it->second;
+            return out;
+        }
+
+        if ((expanded & (detail::kCancelCheckInterval - 1)) == 0 && detail::cancel_requested(cfg)) {
+            out.status = PlanStatus::Cancelled;
+            return out;
+        }
+        ++expanded;
+        for (int k = 0; k < nd; ++k) {
+            int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+            if (!pass.can_move(r, c, dr, dc)) continue;
+            int nr = r + dr, nc = c + dc;
+            int nid = nr*g.cols + nc;
+            double step = (dr && dc) ? diag : 1.0;
+            if (weighted) step *= table[std::min<int>(g.at(nr,nc), 100)];
+            double ng = cur.g + step;
+            if (ng < best[nid]) {
+                best[nid] = ng;
+                parent[nid] = cur.id;
+                open.push({nid, ng, ng + h(nr, nc)});
+            }
+        }
+        max_open = std::max(max_open, open.size());
+    }
+    out.status = PlanStatus::NoPath;
+    return out;
+}
+
+} // namespace engine
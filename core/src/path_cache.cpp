@@ -0,0 +1,205 @@
+#include "engine/path_cache.hpp"
+#include "astar_detail.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace engine {
+
+// FNV-1a
+static void fnv(uint64_t& h, const void* p, size_t n) {
+    const unsigned char* b = static_cast<const unsigned char*>(p);
+    for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+}
+
+uint64_t config_hash(const AstarConfig& cfg) {
+    uint64_t h = 14695981039346656037ull;
+    int32_t v[5] = { cfg.allow_diagonal ? 1 : 0, static_cast<int32_t>(cfg.heuristic), cfg.block_threshold,
+                     static_cast<int32_t>(cfg.inflation_unit), static_cast<int32_t>(cfg.cost_mode) };
+    fnv(h, v, sizeof(v));
+    fnv(h, &cfg.inflation_radius, sizeof(cfg.inflation_radius));
+    if (cfg.cost_mode == CostMode::OccupancyWeighted) {
+        const OccupancyCostTable t = cfg.cost_table ? *cfg.cost_table : default_occupancy_costs();
+        fnv(h, t.data(), t.size() * sizeof(t[0]));
+    }
+    return h;
+}
+
+size_t PathCache::KeyHash::operator()(const Key& k) const {
+    uint64_t h = 14695981039346656037ull;
+    fnv(h, &k.version, sizeof(k.version));
+    fnv(h, &k.cfg, sizeof(k.cfg));
+    int32_t v[4] = { k.r0, k.c0, k.r1, k.c1 };
+    fnv(h, v, sizeof(v));
+    return static_cast<size_t>(h);
+}
+
+PathCache::PathCache(size_t max_bytes) : max_bytes_(max_bytes) {}
+
+void PathCache::erase(EntryList::iterator it) {
+    const Entry& e = *it;
+    exact_.erase(Key{e.version, e.cfg, e.path.front().r, e.path.front().c, e.path.back().r, e.path.back().c});
+    for (const auto& c : e.path) {
+        auto bc = by_cell_.find(Key{e.version, e.cfg, c.r, c.c, 0, 0});
+        if (bc == by_cell_.end()) continue;
+        auto& v = bc->second;
+        v.erase(std::remove_if(v.begin(), v.end(), [&](const CellRef& p) { return p.it == it; }), v.end());
+        if (v.empty()) by_cell_.erase(bc);
+    }
+    stats_.bytes -= e.bytes;
+    --stats_.entries;
+    lru_.erase(it);
+}
+
+std::optional<PlanResult> PathCache::find(const Grid& g, const AstarConfig& cfg, Cell s, Cell t) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const uint64_t h = config_hash(cfg);
+    std::lock_guard<std::mutex> lock(mu_);
+
+    EntryList::iterator hit = lru_.end();
+    int ps = -1, pt = -1;
+    auto ex = exact_.find(Key{g.version, h, s.r, s.c, t.r, t.c});
+    if (ex != exact_.end()) {
+        hit = ex->second;
+        ps = 0;
+        pt = static_cast<int>(hit->path.size()) - 1;
+        ++stats_.hits;
+    } else {
+        // start と goal の両方を通るキャッシュ済み経路を探す
+        // 両方の索引は serial の昇順なので、突き合わせは長さの和に比例する
+        auto bs = by_cell_.find(Key{g.version, h, s.r, s.c, 0, 0});
+        auto bt = by_cell_.find(Key{g.version, h, t.r, t.c, 0, 0});
+        if (bs != by_cell_.end() && bt != by_cell_.end()) {
+            const auto& va = bs->second;
+            const auto& vb = bt->second;
+            for (size_t a = 0, b = 0; a < va.size() && b < vb.size();) {
+                if (va[a].serial < vb[b].serial) { ++a; continue; }
+                if (vb[b].serial < va[a].serial) { ++b; continue; }
+                if (va[a].pos <= vb[b].pos || va[a].it->reversible) {
+                    hit = va[a].it; ps = va[a].pos; pt = vb[b].pos;
+                    break;
+                }
+                ++a; ++b;
+            }
+        }
+        if (hit == lru_.end()) {
+            ++stats_.misses;
+            return std::nullopt;
+        }
+        ++stats_.subpath_hits;
+    }
+    lru_.splice(lru_.begin(), lru_, hit); // 最近使ったものを先頭へ（イテレータは有効なまま）
+
+    PlanResult res;
+    if (ps <= pt) {
+        res.path.assign(hit->path.begin() + ps, hit->path.begin() + pt + 1);
+    } else {
+        res.path.assign(hit->path.rbegin() + (hit->path.size() - 1 - ps), hit->path.rbegin() + (hit->path.size() - pt));
+    }
+    res.stats.cost = std::abs(hit->prefix[pt] - hit->prefix[ps]);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    return res;
+}
+
+void PathCache::insert(const Grid& g, const AstarConfig& cfg, const PlanResult& result) {
+    Entry e;
+    e.path = result.compact ? decode_path(*result.compact) : result.path;
+    if (e.path.empty()) return;
+    e.version = g.version;
+    e.cfg = config_hash(cfg);
+    e.stats = result.stats;
+    e.reversible = (cfg.cost_mode == CostMode::Uniform);
+    float inflation = cfg.inflation_radius;
+    if (cfg.inflation_unit == RadiusUnit::Meters && g.resolution > 0.0f) inflation /= g.resolution;
+    e.margin = 1 + static_cast<int>(std::ceil(std::max(0.0f, inflation)));
+
+    // 区間コスト用の累積コスト（探索と同じ式で計算）
+    e.prefix.resize(e.path.size());
+    e.prefix[0] = 0.0;
+    const OccupancyCostTable table = cfg.cost_table ? *cfg.cost_table : default_occupancy_costs();
+    int64_t acc = 0;
+    for (size_t i = 1; i < e.path.size(); ++i) {
+        const Cell a = e.path[i-1], b = e.path[i];
+        const bool diag = (a.r != b.r) && (a.c != b.c);
+        if (e.reversible) {
+            e.prefix[i] = e.prefix[i-1] + (diag ? std::sqrt(2.0) : 1.0);
+        } else {
+            const int occ = g.in(b.r, b.c) ? std::min<int>(g.at(b.r, b.c), 100) : 100;
+            acc += (diag ? detail::kDiagonalCost : detail::kStraightCost) * table[occ];
+            e.prefix[i] = static_cast<double>(acc) / detail::kStraightCost;
+        }
+    }
+    // 経路・累積コスト・セル索引の分の見積もり
+    e.bytes = sizeof(Entry) + e.path.size() * (sizeof(Cell) + sizeof(double) + 48);
+    if (e.bytes > max_bytes_) return;
+
+    std::lock_guard<std::mutex> lock(mu_);
+    const Key k{e.version, e.cfg, e.path.front().r, e.path.front().c, e.path.back().r, e.path.back().c};
+    auto old = exact_.find(k);
+    if (old != exact_.end()) erase(old->second);
+
+    while (stats_.bytes + e.bytes > max_bytes_ && !lru_.empty()) {
+        erase(std::prev(lru_.end()));
+        ++stats_.evictions;
+    }
+    e.serial = next_serial_++;
+    lru_.push_front(std::move(e));
+    auto it = lru_.begin();
+    exact_[k] = it;
+    for (int i = 0; i < static_cast<int>(it->path.size()); ++i) {
+        const Cell c = it->path[i];
+        by_cell_[Key{it->version, it->cfg, c.r, c.c, 0, 0}].push_back({it, it->serial, i});
+    }
+    stats_.bytes += it->bytes;
+    ++stats_.entries;
+}
+
+size_t PathCache::invalidate_region(int r0, int c0, int r1, int c1) {
+    std::lock_guard<std::mutex> lock(mu_);
+    size_t n = 0;
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        auto next = std::next(it);
+        const int m = it->margin;
+        bool touch = std::any_of(it->path.begin(), it->path.end(), [&](const Cell& c) {
+            return c.r >= r0 - m && c.r <= r1 + m && c.c >= c0 - m && c.c <= c1 + m;
+        });
+        if (touch) { erase(it); ++n; }
+        it = next;
+    }
+    stats_.invalidated += n;
+    return n;
+}
+
+void PathCache::clear() {
+    std::lock_guard<std::mutex> lock(mu_);
+    lru_.clear();
+    exact_.clear();
+    by_cell_.clear();
+    stats_.entries = 0;
+    stats_.bytes = 0;
+}
+
+PathCacheStats PathCache::stats() const {
+    std::lock_guard<std::mutex> lock(mu_);
+    return stats_;
+}
+
+PlanOutcome cached_plan_ex(PathCache& cache, const Grid& g, Cell s, Cell t, const AstarConfig& cfg) {
+    PlanOutcome out;
+    if (auto hit = cache.find(g, cfg, s, t)) {
+        if (cfg.path_format != PathFormat::Cells) {
+            hit->compact = encode_path(hit->path, cfg.path_format);
+            hit->path.clear();
+        }
+        out.status = PlanStatus::Ok;
+        out.result = std::move(hit);
+        return out;
+    }
+    out = astar_plan_ex(g, s, t, cfg);
+    if (out.status == PlanStatus::Ok) cache.insert(g, cfg, *out.result);
+    return out;
+}
+
+} // namespace engine
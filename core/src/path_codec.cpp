@@ -0,0 +1,133 @@
+#include "engine/astar.hpp"
+#include "astar_detail.hpp"
+#include "engine/trace.hpp"
+
+namespace engine {
+
+// RunLength の1バイトに入る最大の回数
+static constexpr int kMaxRun = 32;
+
+// (dr,dc) -> kDirs の添字（隣接でなければ -1）
+static inline int move_code(int dr, int dc) {
+    static constexpr int8_t table[9] = { 7, 1, 6, 3, -1, 2, 5, 0, 4 };
+    if (dr < -1 || dr > 1 || dc < -1 || dc > 1) return -1;
+    return table[(dr + 1) * 3 + (dc + 1)];
+}
+
+static inline void put3(std::vector<uint8_t>& data, size_t bit, int code) {
+    const size_t i = bit >> 3, o = bit & 7;
+    data[i] |= static_cast<uint8_t>(code << o);
+    if (o > 5) data[i + 1] |= static_cast<uint8_t>(code >> (8 - o));
+}
+
+static inline int get3(const std::vector<uint8_t>& data, size_t bit) {
+    const size_t i = bit >> 3, o = bit & 7;
+    unsigned v = data[i] >> o;
+    if (o > 5) v |= static_cast<unsigned>(data[i + 1]) << (8 - o);
+    return static_cast<int>(v & 7u);
+}
+
+// each(fn) が goal 側から逆順に移動コードを fn に渡す。2回走査して、1回目で長さを数え、2回目で末尾から書く
+// cp.data の容量は使い回す
+template <class Each>
+static void encode_reverse(CompactPath& cp, Cell start, PathFormat format, Each&& each) {
+    cp.format = format;
+    cp.start = start;
+    int32_t steps = 0;
+    size_t runs = 0;
+    int last = -1, len = 0;
+    each([&](int code) {
+        ++steps;
+        if (code != last || len == kMaxRun) { ++runs; last = code; len = 0; }
+        ++len;
+    });
+    cp.steps = steps;
+
+    if (format == PathFormat::RunLength) {
+        cp.data.assign(runs, 0);
+        size_t pos = runs;
+        last = -1; len = 0;
+        each([&](int code) {
+            if (code != last || len == kMaxRun) { --pos; last = code; len = 0; }
+            ++len;
+            cp.data[pos] = static_cast<uint8_t>((code << 5) | (len - 1));
+        });
+    } else {
+        cp.data.assign((3 * static_cast<size_t>(steps) + 7) / 8, 0);
+        size_t i = static_cast<size_t>(steps);
+        each([&](int code) { put3(cp.data, 3 * --i, code); });
+    }
+}
+
+std::optional<CompactPath> encode_path(const std::vector<Cell>& path, PathFormat format) {
+    if (path.empty() || format == PathFormat::Cells) return std::nullopt;
+    for (size_t i = 1; i < path.size(); ++i) {
+        if (move_code(path[i].r - path[i-1].r, path[i].c - path[i-1].c) < 0) return std::nullopt;
+    }
+    CompactPath cp;
+    encode_reverse(cp, path.front(), format, [&](auto&& fn) {
+        for (size_t i = path.size() - 1; i > 0; --i) fn(move_code(path[i].r - path[i-1].r, path[i].c - path[i-1].c));
+    });
+    return cp;
+}
+
+std::vector<Cell> decode_path(const CompactPath& cp) {
+    std::vector<Cell> path;
+    if (cp.steps < 0) return path;
+    // 壊れた steps で巨大な確保をしないよう、先に data と突き合わせる
+    if (cp.format == PathFormat::RunLength) {
+        int64_t total = 0;
+        for (uint8_t b : cp.data) total += (b & 31) + 1;
+        if (total != cp.steps) return path;
+    } else if (cp.format != PathFormat::Moves || cp.data.size() * 8 < 3 * static_cast<size_t>(cp.steps)) {
+        return path;
+    }
+    path.reserve(static_cast<size_t>(cp.steps) + 1);
+    Cell cur = cp.start;
+    path.push_back(cur);
+    auto step = [&](int code) {
+        cur.r += detail::kDirs[code][0];
+        cur.c += detail::kDirs[code][1];
+        path.push_back(cur);
+    };
+    if (cp.format == PathFormat::RunLength) {
+        for (uint8_t b : cp.data) {
+            for (int n = (b & 31) + 1; n > 0; --n) step(b >> 5);
+        }
+    } else {
+        for (int32_t i = 0; i < cp.steps; ++i) step(get3(cp.data, 3 * static_cast<size_t>(i)));
+    }
+    if (static_cast<int32_t>(path.size()) != cp.steps + 1) path.clear(); // 壊れたデータ
+    return path;
+}
+
+namespace detail {
+
+void emit_path(PlanResult& res, const int* parent, int cols, Cell s, Cell t, PathFormat format) {
+    TraceScope trace("reconstruct");
+    const int sid = s.r*cols + s.c, tid = t.r*cols + t.c;
+    if (format == PathFormat::Cells) {
+        // 長さを数えてから末尾から書く
+        size_t len = 1;
+        for (int id = tid; id != sid; id = parent[id]) ++len;
+        res.path.resize(len);
+        for (int id = tid; ; id = parent[id]) {
+            res.path[--len] = {id / cols, id % cols};
+            if (id == sid) break;
+        }
+        res.compact.reset();
+        return;
+    }
+    res.path.clear();
+    if (!res.compact) res.compact.emplace();
+    encode_reverse(*res.compact, s, format, [&](auto&& fn) {
+        for (int id = tid; id != sid; ) {
+            const int p = parent[id];
+            fn(move_code(id / cols - p / cols, id % cols - p % cols));
+            id = p;
+        }
+    });
+}
+
+} // namespace detail
+} // namespace engine
@@ -0,0 +1,145 @@
+#include "engine/pyramid.hpp"
+#include "astar_detail.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace engine {
+
+// 1段だけ粗くする
+static Grid downsample(const Grid& fine, int f, DownsampleRule rule, int block_threshold) {
+    Grid g;
+    g.rows = (fine.rows + f - 1) / f; // 端数も1セルにまとめる
+    g.cols = (fine.cols + f - 1) / f;
+    g.resolution = fine.resolution * f;
+    g.origin_x = fine.origin_x;
+    g.origin_y = fine.origin_y;
+    g.occ.assign(static_cast<size_t>(g.rows) * g.cols, 0);
+
+    for (int r = 0; r < fine.rows; ++r) {
+        const uint8_t* row = &fine.occ[static_cast<size_t>(r) * fine.cols];
+        uint8_t* crow = &g.occ[static_cast<size_t>(r / f) * g.cols];
+        for (int c = 0; c < fine.cols; ++c) {
+            uint8_t v = row[c];
+            if (rule == DownsampleRule::AnyBlocked) v = (v >= block_threshold) ? 100 : 0;
+            crow[c / f] = std::max(crow[c / f], v);
+        }
+    }
+    return g;
+}
+
+GridPyramid build_pyramid(const Grid& g, int num_levels, int factor, DownsampleRule rule, int block_threshold) {
+    GridPyramid p;
+    p.factor = std::max(factor, 2);
+    p.levels.push_back(g);
+    for (int l = 1; l < num_levels; ++l) {
+        const Grid& prev = p.levels.back();
+        if (prev.rows <= 1 && prev.cols <= 1) break; // これ以上粗くできない
+        p.levels.push_back(downsample(prev, p.factor, rule, block_threshold));
+    }
+    return p;
+}
+
+// 粗い経路を膨張させて1段細かいグリッド上の回廊マスクを作る
+static std::vector<uint8_t> make_corridor(const Grid& coarse, const Grid& fine, int f,
+                                          const std::vector<Cell>& coarse_path, int radius) {
+    std::vector<uint8_t> cmask(coarse.occ.size(), 0);
+    for (const auto& p : coarse_path) {
+        for (int r = std::max(0, p.r - radius); r <= std::min(coarse.rows - 1, p.r + radius); ++r)
+            for (int c = std::max(0, p.c - radius); c <= std::min(coarse.cols - 1, p.c + radius); ++c)
+                cmask[static_cast<size_t>(r) * coarse.cols + c] = 1;
+    }
+    std::vector<uint8_t> mask(fine.occ.size(), 0);
+    for (int r = 0; r < fine.rows; ++r) {
+        const uint8_t* crow = &cmask[static_cast<size_t>(r / f) * coarse.cols];
+        uint8_t* row = &mask[static_cast<size_t>(r) * fine.cols];
+        for (int c = 0; c < fine.cols; ++c) row[c] = crow[c / f];
+    }
+    return mask;
+}
+
+PyramidPlanOutcome pyramid_plan_ex(const GridPyramid& p, Cell s, Cell t,
+                                   const AstarConfig& cfg, const PyramidConfig& pcfg) {
+    PyramidPlanOutcome out;
+    if (p.levels.empty()) {
+        out.status = PlanStatus::MapError;
+        return out;
+    }
+    const Grid& base = p.levels.front();
+    out.pyramid.total_cells = base.rows * base.cols;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    auto full_search = [&] {
+        auto o = astar_plan_ex(base, s, t, cfg);
+        out.status = o.status;
+        out.result = std::move(o.result);
+        out.pyramid.corridor_cells = out.pyramid.total_cells;
+        if (out.result.has_value()) {
+            auto t1 = std::chrono::high_resolution_clock::now();
+            out.result->stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        }
+        return out;
+    };
+
+    // 1段だけの場合は通常探索
+    const int top = static_cast<int>(p.levels.size()) - 1;
+    if (top == 0) return full_search();
+
+    // 入力チェックは元のグリッドで行う（粗い段の失敗と区別するため）
+    if (base.rows <= 0 || base.cols <= 0 ||
+        base.occ.size() != static_cast<size_t>(base.rows) * static_cast<size_t>(base.cols)) {
+        out.status = PlanStatus::MapError;
+        return out;
+    }
+    if (!base.in(s.r, s.c) || !base.in(t.r, t.c)) {
+        out.status = PlanStatus::OutOfBounds;
+        return out;
+    }
+    if (base.at(s.r, s.c) >= cfg.block_threshold || base.at(t.r, t.c) >= cfg.block_threshold) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+
+    // 各段での start/goal の座標
+    auto at_level = [&](Cell c, int l) {
+        for (int i = 0; i < l; ++i) { c.r /= p.factor; c.c /= p.factor; }
+        return c;
+    };
+
+    // 膨張は最下段だけに適用する（距離場は元のグリッドのもの）
+    AstarConfig coarse_cfg = cfg;
+    coarse_cfg.inflation_radius = 0.0f;
+    coarse_cfg.distance_field = nullptr;
+    coarse_cfg.path_format = PathFormat::Cells; // 回廊を作るのにセル列が要る
+
+    std::vector<uint8_t> corridor;
+    std::optional<PlanResult> res;
+    for (int l = top; l >= 0; --l) {
+        detail::SearchOptions opt;
+        opt.allowed = corridor.empty() ? nullptr : &corridor;
+        opt.free_endpoints = (l > 0); // 粗い段では start/goal を含むセルが塞がっていても探索する
+        auto o = detail::astar_search(p.levels[l], at_level(s, l), at_level(t, l), l > 0 ? coarse_cfg : cfg, opt);
+        if (o.status != PlanStatus::Ok) {
+            if (!pcfg.fallback_full || o.status == PlanStatus::Cancelled) {
+                out.status = o.status;
+                return out;
+            }
+            out.pyramid.fallback = true;
+            return full_search();
+        }
+        res = std::move(o.result);
+        if (l > 0) {
+            out.pyramid.coarse_expanded += res->stats.expanded;
+            out.pyramid.coarse_max_open = std::max(out.pyramid.coarse_max_open, res->stats.max_open);
+            corridor = make_corridor(p.levels[l], p.levels[l - 1], p.factor, res->path, pcfg.corridor_radius);
+        }
+    }
+    out.pyramid.corridor_cells = static_cast<int>(std::count(corridor.begin(), corridor.end(), 1));
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res->stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    out.status = PlanStatus::Ok;
+    out.result = std::move(res);
+    return out;
+}
+
+} // namespace engine
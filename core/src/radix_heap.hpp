@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+// ライブラリ内部専用
+namespace engine::detail {
+
+// 単調な整数キー用の radix heap（取り出すキーが減らない A*/Dijkstra 向け）
+// push するキーは最後に pop したキー以上であること
+template <class T>
+class RadixHeap {
+public:
+    using Item = std::pair<uint64_t, T>;
+
+    // バケットの確保先（nullptrなら既定のヒープ）
+    explicit RadixHeap(std::pmr::memory_resource* mr = nullptr)
+        : buckets_(mr ? mr : std::pmr::get_default_resource()) {
+        buckets_.resize(65); // 各バケットも同じ確保先を使う
+    }
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void push(uint64_t key, const T& v) {
+        buckets_[bucket_of(key)].push_back({key, v});
+        ++size_;
+    }
+
+    // 最小キーの要素を取り出す（空でないこと）
+    Item pop() {
+        if (buckets_[0].empty()) {
+            int i = 1;
+            while (buckets_[i].empty()) ++i;
+            // バケット i の最小キーを新しい基準にして再分配（各要素はより小さいバケットへ移る）
+            uint64_t mn = buckets_[i][0].first;
+            for (const auto& it : buckets_[i]) if (it.first < mn) mn = it.first;
+            last_ = mn;
+            for (const auto& it : buckets_[i]) buckets_[bucket_of(it.first)].push_back(it);
+            buckets_[i].clear();
+        }
+        Item it = buckets_[0].back();
+        buckets_[0].pop_back();
+        --size_;
+        return it;
+    }
+
+    void clear() {
+        for (auto& b : buckets_) b.clear();
+        last_ = 0;
+        size_ = 0;
+    }
+
+private:
+    inline int bucket_of(uint64_t key) const {
+        return key == last_ ? 0 : 64 - __builtin_clzll(key ^ last_);
+    }
+    std::pmr::vector<std::pmr::vector<Item>> buckets_;
+    uint64_t last_ = 0;
+    size_t size_ = 0;
+};
+
+} // namespace engine::detail
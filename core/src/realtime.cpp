@@ -0,0 +1,249 @@
+#include "engine/realtime.hpp"
+#include "engine/trace.hpp"
+#include "astar_detail.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace engine {
+
+using detail::kDirs;
+using detail::kStraightCost;
+using detail::kDiagonalCost;
+
+static constexpr int64_t kInf = std::numeric_limits<int64_t>::max() / 4;
+
+static inline size_t hash_cell(int cell, int shift) {
+    return static_cast<size_t>((static_cast<uint64_t>(static_cast<uint32_t>(cell)) * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+// 最小ヒープ（key が小さい順、同じなら g が大きい順）
+static inline bool heap_after(int64_t ka, int64_t ga, int64_t kb, int64_t gb) {
+    return ka != kb ? ka > kb : ga < gb;
+}
+
+RealtimeAgent::RealtimeAgent(const Grid& g, Cell goal, const AstarConfig& cfg, const RealtimeConfig& rcfg)
+    : g_(g), cfg_(cfg), rcfg_(rcfg), goal_(goal) {
+    rcfg_.lookahead = std::max(1, rcfg_.lookahead);
+
+    // 膨張に使う距離場は tick ごとに計算しないよう先に用意する
+    float inflation = cfg.inflation_radius;
+    if (cfg.inflation_unit == RadiusUnit::Meters && g.resolution > 0.0f) inflation /= g.resolution;
+    const DistanceField* df = cfg.distance_field;
+    if (inflation > 0.0f && (!df || df->rows != g.rows || df->cols != g.cols || df->block_threshold != cfg.block_threshold)) {
+        df_ = compute_distance_field(g, cfg.block_threshold);
+        cfg_.distance_field = &df_;
+    }
+
+    table_ = cfg.cost_table ? *cfg.cost_table : default_occupancy_costs();
+    if (cfg.cost_mode == CostMode::OccupancyWeighted) wmin_ = detail::min_passable_weight(table_, cfg.block_threshold);
+
+    // 1 tick のノード数は 1 + lookahead*近傍数 を超えないので、作業用の表は最初に確保しきる
+    const size_t max_nodes = 1 + static_cast<size_t>(rcfg_.lookahead) * detail::num_dirs(cfg);
+    size_t cap = 16;
+    local_shift_ = 60;
+    while (cap < max_nodes * 2) { cap <<= 1; --local_shift_; }
+    local_keys_.assign(cap, -1);
+    local_idx_.assign(cap, -1);
+    local_stamp_.assign(cap, 0);
+    nodes_.reserve(max_nodes);
+    heap_.reserve(max_nodes * 2);
+
+    reset_learning();
+}
+
+void RealtimeAgent::reset_learning() {
+    keys_.assign(1024, -1);
+    vals_.assign(1024, 0);
+    shift_ = 64 - 10;
+    learned_ = 0;
+}
+
+void RealtimeAgent::set_goal(Cell goal) {
+    if (goal.r == goal_.r && goal.c == goal_.c) return;
+    goal_ = goal;
+    reset_learning();
+}
+
+int64_t RealtimeAgent::base_h(int cell) const {
+    const int64_t dr = std::abs(cell / g_.cols - goal_.r), dc = std::abs(cell % g_.cols - goal_.c);
+    if (!cfg_.allow_diagonal) return wmin_ * kStraightCost * (dr + dc);
+    const int64_t dmin = std::min(dr, dc), dmax = std::max(dr, dc);
+    return wmin_ * (kDiagonalCost * dmin + kStraightCost * (dmax - dmin));
+}
+
+size_t RealtimeAgent::learned_slot(int cell) const {
+    const size_t mask = keys_.size() - 1;
+    size_t i = hash_cell(cell, shift_);
+    while (keys_[i] != -1 && keys_[i] != cell) i = (i + 1) & mask;
+    return i;
+}
+
+int64_t RealtimeAgent::h(int cell) const {
+    const size_t i = learned_slot(cell);
+    if (keys_[i] != cell) return base_h(cell);
+    return vals_[i] == kDead ? kInf : static_cast<int64_t>(vals_[i]);
+}
+
+void RealtimeAgent::learn(int cell, int64_t v) {
+    // 32bit に収まらない値は下に丸める（許容的なまま）
+    const uint32_t val = v >= kInf ? kDead : static_cast<uint32_t>(std::min<int64_t>(v, kDead - 1));
+    size_t i = learned_slot(cell);
+    if (keys_[i] != cell) {
+        if ((learned_ + 1) * 2 > keys_.size()) {
+            std::vector<int32_t> keys(keys_.size() * 2, -1);
+            std::vector<uint32_t> vals(vals_.size() * 2, 0);
+            keys.swap(keys_);
+            vals.swap(vals_);
+            --shift_;
+            for (size_t j = 0; j < keys.size(); ++j) {
+                if (keys[j] == -1) continue;
+                const size_t k = learned_slot(keys[j]);
+                keys_[k] = keys[j];
+                vals_[k] = vals[j];
+            }
+            i = learned_slot(cell);
+        }
+        keys_[i] = cell;
+        ++learned_;
+    }
+    vals_[i] = val;
+}
+
+int RealtimeAgent::find_local(int cell) const {
+    const size_t mask = local_keys_.size() - 1;
+    for (size_t i = hash_cell(cell, local_shift_);; i = (i + 1) & mask) {
+        if (local_stamp_[i] != stamp_) return -1;
+        if (local_keys_[i] == cell) return local_idx_[i];
+    }
+}
+
+int RealtimeAgent::local(int cell) {
+    const size_t mask = local_keys_.size() - 1;
+    size_t i = hash_cell(cell, local_shift_);
+    for (; local_stamp_[i] == stamp_; i = (i + 1) & mask) {
+        if (local_keys_[i] == cell) return local_idx_[i];
+    }
+    local_stamp_[i] = stamp_;
+    local_keys_[i] = cell;
+    local_idx_[i] = static_cast<int>(nodes_.size());
+    nodes_.push_back({cell, -1, kInf, 0, false});
+    return local_idx_[i];
+}
+
+RealtimeStep RealtimeAgent::tick(Cell cur) {
+    TraceScope trace("realtime_tick");
+    RealtimeStep step;
+    step.status = detail::validate(g_, cur, goal_);
+    if (step.status != PlanStatus::Ok) return step;
+
+    detail::Passability pass(g_, cfg_);
+    if (pass.blocked(cur.r, cur.c) || pass.blocked(goal_.r, goal_.c)) {
+        step.status = PlanStatus::InvalidArg;
+        return step;
+    }
+    if (cur.r == goal_.r && cur.c == goal_.c) {
+        step.at_goal = true;
+        return step;
+    }
+    const int cid = cur.r*g_.cols + cur.c, gid = goal_.r*g_.cols + goal_.c;
+    if (h(cid) >= kInf) {
+        step.status = PlanStatus::NoPath;
+        return step;
+    }
+
+    const bool weighted = cfg_.cost_mode == CostMode::OccupancyWeighted;
+    auto move_cost = [&](int k, int to) -> int64_t {
+        const int64_t base = k < 4 ? kStraightCost : kDiagonalCost;
+        return weighted ? base * table_[std::min<int>(g_.occ[to], 100)] : base;
+    };
+    auto cmp = [](const HeapItem& a, const HeapItem& b) { return heap_after(a.key, a.g, b.key, b.g); };
+    auto push = [&](int64_t key, int64_t g, int idx) {
+        heap_.push_back({key, g, idx});
+        std::push_heap(heap_.begin(), heap_.end(), cmp);
+    };
+    const int nd = detail::num_dirs(cfg_);
+
+    // 1. 先読み: 現在地から lookahead 個まで A* で展開する
+    ++stamp_;
+    nodes_.clear();
+    heap_.clear();
+    const int root = local(cid);
+    nodes_[root].g = 0;
+    push(h(cid), 0, root);
+    int target = -1;
+    while (!heap_.empty()) {
+        const HeapItem top = heap_.front();
+        const Node n = nodes_[top.idx];
+        if (n.closed || top.g != n.g) { // 古い要素
+            std::pop_heap(heap_.begin(), heap_.end(), cmp);
+            heap_.pop_back();
+            continue;
+        }
+        if (n.cell == gid || step.expanded == rcfg_.lookahead) { target = top.idx; break; }
+        std::pop_heap(heap_.begin(), heap_.end(), cmp);
+        heap_.pop_back();
+        nodes_[top.idx].closed = true;
+        ++step.expanded;
+
+        const int r = n.cell / g_.cols, c = n.cell % g_.cols;
+        for (int k = 0; k < nd; ++k) {
+            if (!pass.can_move(r, c, kDirs[k][0], kDirs[k][1])) continue;
+            const int to = (r + kDirs[k][0])*g_.cols + (c + kDirs[k][1]);
+            const int64_t hv = h(to);
+            if (hv >= kInf) continue;
+            const int64_t ng = n.g + move_cost(k, to);
+            const int j = local(to);
+            if (!nodes_[j].closed && ng < nodes_[j].g) {
+                nodes_[j].g = ng;
+                nodes_[j].parent = top.idx;
+                push(ng + hv, ng, j);
+            }
+        }
+    }
+
+    // 2. 学習: 閉じたノードを ∞ にし、open のノードから逆向きに Dijkstra で h を伝える
+    heap_.clear();
+    for (int i = 0; i < static_cast<int>(nodes_.size()); ++i) {
+        Node& n = nodes_[i];
+        n.h = n.closed ? kInf : h(n.cell);
+        if (!n.closed) push(n.h, 0, i);
+    }
+    while (!heap_.empty()) {
+        std::pop_heap(heap_.begin(), heap_.end(), cmp);
+        const HeapItem top = heap_.back();
+        heap_.pop_back();
+        const Node n = nodes_[top.idx];
+        if (top.key != n.h) continue; // 古い要素
+        const int r = n.cell / g_.cols, c = n.cell % g_.cols;
+        for (int k = 0; k < nd; ++k) {
+            const int pr = r - kDirs[k][0], pc = c - kDirs[k][1];
+            if (!pass.free(pr, pc) || !pass.can_move(pr, pc, kDirs[k][0], kDirs[k][1])) continue;
+            const int j = find_local(pr*g_.cols + pc);
+            if (j < 0 || !nodes_[j].closed) continue;
+            const int64_t nh = n.h + move_cost(k, n.cell);
+            if (nh < nodes_[j].h) {
+                nodes_[j].h = nh;
+                push(nh, 0, j);
+            }
+        }
+    }
+    for (const Node& n : nodes_) {
+        if (n.closed && n.h > h(n.cell)) {
+            learn(n.cell, n.h);
+            ++step.updated;
+        }
+    }
+
+    if (target < 0) { // 到達できる範囲を展開しきった
+        step.status = PlanStatus::NoPath;
+        return step;
+    }
+
+    // 3. 移動: open list の最良ノード（またはゴール）までの経路の先頭 max_moves 個
+    for (int i = target; i != root; i = nodes_[i].parent) step.moves.push_back({nodes_[i].cell / g_.cols, nodes_[i].cell % g_.cols});
+    std::reverse(step.moves.begin(), step.moves.end());
+    if (rcfg_.max_moves > 0 && static_cast<int>(step.moves.size()) > rcfg_.max_moves) step.moves.resize(rcfg_.max_moves);
+    return step;
+}
+
+} // namespace engine
@@ -0,0 +1,118 @@
+#include "engine/scheduler.hpp"
+#include "astar_detail.hpp"
+#include <algorithm>
+
+namespace engine {
+
+bool PlanScheduler::later(const Job& a, const Job& b) {
+    if (a.deadline != b.deadline) return a.deadline > b.deadline;
+    if (a.priority != b.priority) return a.priority > b.priority;
+    return a.seq > b.seq;
+}
+
+PlanScheduler::PlanScheduler(const SchedulerConfig& cfg) : drop_expired_(cfg.drop_expired) {
+    int n = cfg.num_threads;
+    if (n <= 0) n = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int i = 0; i < n; ++i) workers_.emplace_back([this] { worker(); });
+}
+
+PlanScheduler::~PlanScheduler() {
+    cancel_pending();
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+std::future<PlanOutcome> PlanScheduler::submit(const PlanQuery& query, QueryPriority priority,
+                                               Clock::time_point deadline) {
+    Job job{query, priority, deadline, Clock::now(), 0, {}};
+    auto fut = job.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        job.seq = next_seq_++;
+        ++stats_.per_class[static_cast<int>(priority)].submitted;
+        heap_.push_back(std::move(job));
+        std::push_heap(heap_.begin(), heap_.end(), later);
+    }
+    cv_.notify_one();
+    return fut;
+}
+
+// mu_ を持った状態で呼ぶ
+void PlanScheduler::finish_cancelled(Job& job) {
+    ++stats_.per_class[static_cast<int>(job.priority)].cancelled;
+    PlanOutcome out;
+    out.status = PlanStatus::Cancelled;
+    job.promise.set_value(std::move(out));
+}
+
+void PlanScheduler::cancel_pending() {
+    std::lock_guard<std::mutex> lk(mu_);
+    for (auto& job : heap_) finish_cancelled(job);
+    heap_.clear();
+}
+
+size_t PlanScheduler::pending() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return heap_.size();
+}
+
+SchedulerStats PlanScheduler::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+void PlanScheduler::worker() {
+    for (;;) {
+        std::unique_lock<std::mutex> lk(mu_);
+        cv_.wait(lk, [&] { return stop_ || !heap_.empty(); });
+        if (heap_.empty()) return; // stop_
+
+        std::pop_heap(heap_.begin(), heap_.end(), later);
+        Job job = std::move(heap_.back());
+        heap_.pop_back();
+
+        const auto start = Clock::now();
+        const bool expired = drop_expired_ && start > job.deadline;
+        if (expired || detail::cancel_requested(job.query.cfg)) {
+            if (expired) ++stats_.per_class[static_cast<int>(job.priority)].deadline_missed;
+            finish_cancelled(job);
+            continue;
+        }
+        lk.unlock();
+
+        // 締切は探索側でも見て、実行中に過ぎたら打ち切る
+        if (drop_expired_) job.query.cfg.deadline = std::min(job.query.cfg.deadline, job.deadline);
+
+        PlanOutcome out;
+        if (job.query.grid) {
+            out = astar_plan_ex(*job.query.grid, job.query.start, job.query.goal, job.query.cfg);
+        } else {
+            out.status = PlanStatus::MapError;
+        }
+        const auto end = Clock::now();
+
+        lk.lock();
+        auto& cs = stats_.per_class[static_cast<int>(job.priority)];
+        if (out.status == PlanStatus::Cancelled) {
+            ++cs.cancelled;
+            if (end > job.deadline) ++cs.deadline_missed;
+        } else {
+            const double wait = std::chrono::duration<double, std::milli>(start - job.submitted).count();
+            const double run = std::chrono::duration<double, std::milli>(end - start).count();
+            ++cs.completed;
+            if (end > job.deadline) ++cs.deadline_missed;
+            cs.wait_ms_total += wait;
+            cs.wait_ms_max = std::max(cs.wait_ms_max, wait);
+            cs.run_ms_total += run;
+            cs.run_ms_max = std::max(cs.run_ms_max, run);
+        }
+        lk.unlock();
+        job.promise.set_value(std::move(out));
+    }
+}
+
+} // namespace engine
@@ -0,0 +1,344 @@
+#include "engine/subgoal.hpp"
+#include "astar_detail.hpp"
+#include "binary_io.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <thread>
+
+namespace engine {
+
+namespace {
+
+// ヒューリスティック距離を (直進数, 斜め数) の組で表す（√2 が無理数なので組の一致 = 距離の一致）
+struct HDist { int straight, diag; };
+inline bool operator==(HDist a, HDist b) { return a.straight == b.straight && a.diag == b.diag; }
+
+inline HDist hdist(bool diag, Cell a, Cell b) {
+    int dr = std::abs(a.r - b.r), dc = std::abs(a.c - b.c);
+    if (!diag) return {dr + dc, 0};
+    return {std::max(dr, dc) - std::min(dr, dc), std::min(dr, dc)};
+}
+inline double hvalue(HDist h) { return h.straight + std::sqrt(2.0) * h.diag; }
+
+// 探索で使う作業領域（スタンプ方式で毎回のクリアを省く）
+struct Scratch {
+    std::vector<uint32_t> stamp;
+    uint32_t cur = 0;
+    std::vector<int> stack;
+    explicit Scratch(int n) : stamp(n, 0) {}
+    void next() {
+        if (++cur == 0) { std::fill(stamp.begin(), stamp.end(), 0); cur = 1; }
+    }
+};
+
+// x から直接 h-reachable なサブゴール（と extra）を集める。サブゴールに着いたらその先は展開しない
+void direct_reachable(const Grid& g, const detail::Passability& pass, bool diag,
+                      const std::vector<int32_t>& id_of, Cell x, int extra,
+                      Scratch& sc, std::vector<int>& found) {
+    const int nd = diag ? 8 : 4;
+    sc.next();
+    const int xid = x.r*g.cols + x.c;
+    sc.stamp[xid] = sc.cur;
+    sc.stack.assign(1, xid);
+    while (!sc.stack.empty()) {
+        int id = sc.stack.back(); sc.stack.pop_back();
+        Cell u{id / g.cols, id % g.cols};
+        HDist hu = hdist(diag, x, u);
+        for (int k = 0; k < nd; ++k) {
+            int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+            Cell n{u.r + dr, u.c + dc};
+            int nid = n.r*g.cols + n.c;
+            if (!pass.can_move(u.r, u.c, dr, dc) || sc.stamp[nid] == sc.cur) continue;
+            HDist step = (dr && dc) ? HDist{0, 1} : HDist{1, 0};
+            if (!(hdist(diag, x, n) == HDist{hu.straight + step.straight, hu.diag + step.diag})) continue;
+            sc.stamp[nid] = sc.cur;
+            if (id_of[nid] >= 0 || nid == extra) {
+                found.push_back(nid);
+                continue;
+            }
+            sc.stack.push_back(nid);
+        }
+    }
+}
+
+// h-reachable な a→b を最適なセル列に展開する（a を含まず b を含む）
+bool expand_segment(const detail::Passability& pass, bool diag,
+                    Cell a, Cell b, std::vector<Cell>& path) {
+    const int r0 = std::min(a.r, b.r), c0 = std::min(a.c, b.c);
+    const int w = std::abs(a.c - b.c) + 1, h = std::abs(a.r - b.r) + 1; // 経路はバウンディングボックス内
+    const HDist total = hdist(diag, a, b);
+    std::vector<int> parent(static_cast<size_t>(w) * h, -2);
+    auto local = [&](Cell c) { return (c.r - r0) * w + (c.c - c0); };
+    std::vector<Cell> stack{a};
+    parent[local(a)] = -1;
+    const int nd = diag ? 8 : 4;
+    while (!stack.empty()) {
+        Cell u = stack.back(); stack.pop_back();
+        if (u.r == b.r && u.c == b.c) break;
+        const HDist au = hdist(diag, a, u);
+        for (int k = 0; k < nd; ++k) {
+            int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+            Cell n{u.r + dr, u.c + dc};
+            if (n.r < r0 || n.c < c0 || n.r >= r0 + h || n.c >= c0 + w) continue;
+            if (parent[local(n)] != -2 || !pass.can_move(u.r, u.c, dr, dc)) continue;
+            // a からの距離がちょうど1歩分増え、かつ b への最短の帯に残る移動だけ（帯の中の横移動は遠回り）
+            HDist step = (dr && dc) ? HDist{0, 1} : HDist{1, 0};
+            HDist an = hdist(diag, a, n), nb = hdist(diag, n, b);
+            if (!(an == HDist{au.straight + step.straight, au.diag + step.diag})) continue;
+            if (!(HDist{an.straight + nb.straight, an.diag + nb.diag} == total)) continue;
+            parent[local(n)] = local(u);
+            stack.push_back(n);
+        }
+    }
+    if (parent[local(b)] == -2) return false;
+    size_t mark = path.size();
+    for (int l = local(b); l != local(a); l = parent[l]) path.push_back({r0 + l / w, c0 + l % w});
+    std::reverse(path.begin() + static_cast<std::ptrdiff_t>(mark), path.end());
+    return true;
+}
+
+AstarConfig graph_config(const SubgoalGraph& sg) {
+    AstarConfig cfg;
+    cfg.allow_diagonal = sg.allow_diagonal;
+    cfg.block_threshold = sg.block_threshold;
+    cfg.inflation_radius = sg.inflation_cells;
+    return cfg;
+}
+
+} // namespace
+
+std::optional<SubgoalGraph> build_subgoal_graph(const Grid& g, const AstarConfig& cfg, int num_threads) {
+    if (detail::validate(g, {0,0}, {0,0}) != PlanStatus::Ok) return std::nullopt;
+    if (cfg.cost_mode != CostMode::Uniform) return std::nullopt;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    SubgoalGraph sg;
+    sg.rows = g.rows;
+    sg.cols = g.cols;
+    sg.allow_diagonal = cfg.allow_diagonal;
+    sg.block_threshold = cfg.block_threshold;
+    sg.inflation_cells = cfg.inflation_radius;
+    if (cfg.inflation_unit == RadiusUnit::Meters && g.resolution > 0.0f) sg.inflation_cells /= g.resolution;
+    sg.fingerprint = detail::map_fingerprint(g, sg.allow_diagonal, sg.block_threshold, sg.inflation_cells);
+
+    const AstarConfig gcfg = graph_config(sg);
+    detail::Passability pass(g, gcfg, nullptr);
+
+    // 凸な角: 斜め隣が障害物で、その両側の上下左右が通行可能なセル
+    const int N = g.rows * g.cols;
+    sg.id_of.assign(N, -1);
+    for (int r = 0; r < g.rows; ++r) {
+        for (int c = 0; c < g.cols; ++c) {
+            if (pass.blocked(r, c)) continue;
+            for (int k = 4; k < 8; ++k) {
+                int dr = detail::kDirs[k][0], dc = detail::kDirs[k][1];
+                if (!g.in(r+dr, c+dc) || !pass.blocked(r+dr, c+dc)) continue;
+                if (pass.free(r+dr, c) && pass.free(r, c+dc)) {
+                    sg.id_of[r*g.cols + c] = static_cast<int32_t>(sg.subgoals.size());
+                    sg.subgoals.push_back({r, c});
+                    break;
+                }
+            }
+        }
+    }
+
+    const int S = static_cast<int>(sg.subgoals.size());
+    if (num_threads <= 0) num_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    num_threads = std::max(1, std::min(num_threads, std::max(S, 1)));
+
+    // サブゴールごとの辺（直接 h-reachable なサブゴール）を並列に計算
+    std::vector<std::vector<int32_t>> adj(S);
+    std::atomic<int> next{0};
+    auto worker = [&] {
+        Scratch sc(N);
+        std::vector<int> found;
+        for (int i = next++; i < S; i = next++) {
+            found.clear();
+            direct_reachable(g, pass, sg.allow_diagonal, sg.id_of, sg.subgoals[i], -1, sc, found);
+            for (int cell : found) adj[i].push_back(sg.id_of[cell]);
+            std::sort(adj[i].begin(), adj[i].end());
+        }
+    };
+    std::vector<std::thread> th;
+    for (int i = 0; i < num_threads; ++i) th.emplace_back(worker);
+    for (auto& t : th) t.join();
+
+    sg.edge_offsets.resize(static_cast<size_t>(S) + 1);
+    size_t total = 0;
+    for (int i = 0; i < S; ++i) { sg.edge_offsets[i] = static_cast<uint32_t>(total); total += adj[i].size(); }
+    sg.edge_offsets[S] = static_cast<uint32_t>(total);
+    sg.edges.reserve(total);
+    for (auto& a : adj) sg.edges.insert(sg.edges.end(), a.begin(), a.end());
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    sg.stats.build_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    sg.stats.subgoals = S;
+    sg.stats.edges = total;
+    sg.stats.threads = num_threads;
+    return sg;
+}
+
+PlanOutcome subgoal_plan_ex(const SubgoalGraph& sg, const Grid& g, Cell s, Cell t) {
+    PlanOutcome out;
+    out.status = detail::validate(g, s, t);
+    if (out.status != PlanStatus::Ok) return out;
+    if (g.rows != sg.rows || g.cols != sg.cols || sg.id_of.size() != g.occ.size() ||
+        sg.edge_offsets.size() != sg.subgoals.size() + 1) {
+        out.status = PlanStatus::MapError;
+        return out;
+    }
+    const AstarConfig cfg = graph_config(sg);
+    detail::Passability pass(g, cfg, nullptr);
+    if (pass.blocked(s.r, s.c) || pass.blocked(t.r, t.c)) {
+        out.status = PlanStatus::InvalidArg;
+        return out;
+    }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    if (s.r == t.r && s.c == t.c) {
+        out.status = PlanStatus::Ok;
+        out.result = PlanResult{ {s}, {}, std::nullopt };
+        return out;
+    }
+    const bool diag = sg.allow_diagonal;
+    const int S = static_cast<int>(sg.subgoals.size());
+    const int sid = s.r*g.cols + s.c, tid = t.r*g.cols + t.c;
+
+    // グラフのノード: サブゴール 0..S-1, start=S, goal=S+1（サブゴール上ならそのID）
+    const int snode = sg.id_of[sid] >= 0 ? sg.id_of[sid] : S;
+    const int tnode = sg.id_of[tid] >= 0 ? sg.id_of[tid] : S + 1;
+    auto cell_of = [&](int v) { return v < S ? sg.subgoals[v] : (v == S ? s : t); };
+
+    // start と goal をグラフに接続
+    Scratch sc(g.rows * g.cols);
+    std::vector<int> from_start, to_goal;
+    if (snode == S) direct_reachable(g, pass, diag, sg.id_of, s, tid, sc, from_start);
+    std::vector<uint8_t> goal_link(S + 2, 0); // goal へ直接行けるノード
+    if (tnode == S + 1) {
+        direct_reachable(g, pass, diag, sg.id_of, t, sid, sc, to_goal);
+        for (int cell : to_goal) goal_link[cell == sid ? snode : sg.id_of[cell]] = 1;
+    }
+    auto node_of_cell = [&](int cell) { return cell == tid ? tnode : sg.id_of[cell]; };
+
+    // サブゴールグラフ上の A*
+    struct QNode { int v; double g, f; };
+    auto cmp = [](const QNode& a, const QNode& b) { return a.f > b.f; };
+    std::priority_queue<QNode, std::vector<QNode>, decltype(cmp)> open(cmp);
+    std::vector<double> best(S + 2, std::numeric_limits<double>::infinity());
+    std::vector<int> parent(S + 2, -1);
+    auto h = [&](int v) { return hvalue(hdist(diag, cell_of(v), t)); };
+
+    best[snode] = 0.0;
+    open.push({snode, 0.0, h(snode)});
+    int expanded = 0;
+    size_t max_open = 1;
+    bool found = false;
+
+    while (!open.empty()) {
+        QNode cur = open.top(); open.pop();
+        if (cur.g > best[cur.v]) continue;
+        if (cur.v == tnode) { found = true; break; }
+        ++expanded;
+        auto relax = [&](int w) {
+            double ng = cur.g + hvalue(hdist(diag, cell_of(cur.v), cell_of(w)));
+            if (ng < best[w]) {
+                best[w] = ng;
+                parent[w] = cur.v;
+                open.push({w, ng, ng + h(w)});
+            }
+        };
+        if (cur.v == S) {
+            for (int cell : from_start) relax(node_of_cell(cell));
+        } else if (cur.v < S) {
+            for (uint32_t e = sg.edge_offsets[cur.v]; e < sg.edge_offsets[cur.v + 1]; ++e) relax(sg.edges[e]);
+        }
+        if (goal_link[cur.v]) relax(tnode);
+        max_open = std::max(max_open, open.size());
+    }
+    if (!found) {
+        out.status = PlanStatus::NoPath;
+        return out;
+    }
+
+    // サブゴール列をセル列に展開
+    std::vector<int> nodes;
+    for (int v = tnode; v != -1; v = parent[v]) nodes.push_back(v);
+    std::reverse(nodes.begin(), nodes.end());
+    PlanResult res;
+    res.path.push_back(s);
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        if (!expand_segment(pass, diag, cell_of(nodes[i-1]), cell_of(nodes[i]), res.path)) {
+            out.status = PlanStatus::MapError; // グラフがマップと合っていない
+            return out;
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    res.stats.cost = best[tnode];
+    res.stats.expanded = expanded;
+    res.stats.time_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    res.stats.max_open = static_cast<int>(max_open);
+    out.status = PlanStatus::Ok;
+    out.result = std::move(res);
+    return out;
+}
+
+static constexpr char kSubgoalMagic[4] = {'S','S','G','2'};
+
+bool save_subgoal_graph(const SubgoalGraph& sg, const std::string& path) {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) return false;
+    int32_t hdr[4] = { sg.rows, sg.cols, sg.allow_diagonal ? 1 : 0, sg.block_threshold };
+    ofs.write(kSubgoalMagic, sizeof(kSubgoalMagic));
+    ofs.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+    ofs.write(reinterpret_cast<const char*>(&sg.inflation_cells), sizeof(sg.inflation_cells));
+    ofs.write(reinterpret_cast<const char*>(&sg.fingerprint), sizeof(sg.fingerprint));
+    detail::write_vec(ofs, sg.subgoals);
+    detail::write_vec(ofs, sg.edge_offsets);
+    detail::write_vec(ofs, sg.edges);
+    return static_cast<bool>(ofs);
+}
+
+std::optional<SubgoalGraph> load_subgoal_graph(const std::string& path, const Grid& g) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return std::nullopt;
+    char magic[4];
+    int32_t hdr[4];
+    SubgoalGraph sg;
+    if (!ifs.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, kSubgoalMagic)) return std::nullopt;
+    if (!ifs.read(reinterpret_cast<char*>(hdr), sizeof(hdr)) || hdr[0] <= 0 || hdr[1] <= 0) return std::nullopt;
+    if (!ifs.read(reinterpret_cast<char*>(&sg.inflation_cells), sizeof(sg.inflation_cells))) return std::nullopt;
+    if (!ifs.read(reinterpret_cast<char*>(&sg.fingerprint), sizeof(sg.fingerprint))) return std::nullopt;
+    sg.rows = hdr[0];
+    sg.cols = hdr[1];
+    sg.allow_diagonal = hdr[2] != 0;
+    sg.block_threshold = hdr[3];
+    // 別の地図で作ったものは使わない（大きさだけ同じでもサブゴールと辺が合わない）
+    if (sg.fingerprint != detail::map_fingerprint(g, sg.allow_diagonal, sg.block_threshold, sg.inflation_cells))
+        return std::nullopt;
+    const uint64_t N = static_cast<uint64_t>(sg.rows) * sg.cols;
+    if (!detail::read_vec(ifs, sg.subgoals, N) || !detail::read_vec(ifs, sg.edge_offsets, N + 1) ||
+        !detail::read_vec(ifs, sg.edges, std::numeric_limits<uint32_t>::max()))
+        return std::nullopt;
+    const size_t S = sg.subgoals.size();
+    if (sg.edge_offsets.size() != S + 1 || sg.edge_offsets[S] != sg.edges.size()) return std::nullopt;
+
+    // id_of はサブゴール列から復元
+    sg.id_of.assign(N, -1);
+    for (size_t i = 0; i < S; ++i) {
+        const Cell c = sg.subgoals[i];
+        if (c.r < 0 || c.c < 0 || c.r >= sg.rows || c.c >= sg.cols) return std::nullopt;
+        if (sg.edge_offsets[i] > sg.edge_offsets[i + 1]) return std::nullopt;
+        sg.id_of[c.r*sg.cols + c.c] = static_cast<int32_t>(i);
+    }
+    for (int32_t e : sg.edges) if (e < 0 || static_cast<size_t>(e) >= S) return std::nullopt;
+    sg.stats.subgoals = static_cast<int>(S);
+    sg.stats.edges = sg.edges.size();
+    return sg;
+}
+
+} // namespace engine
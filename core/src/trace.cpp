@@ -0,0 +1,165 @@
+#include "engine/trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+
+namespace engine {
+
+namespace detail {
+std::atomic<TraceRecorder*> g_trace_recorder{nullptr};
+}
+
+// スレッドごとの小さな連番（Chrome trace の tid 用）
+static uint32_t thread_seq() {
+    static std::atomic<uint32_t> next{0};
+    thread_local uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+TraceRecorder::TraceRecorder() : epoch_(Clock::now()) {}
+
+void TraceRecorder::add(const char* name, const char* cat, Clock::time_point begin, Clock::time_point end) {
+    const int64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(begin - epoch_).count();
+    const int64_t dur = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    const uint32_t tid = thread_seq();
+    std::lock_guard<std::mutex> lk(mu_);
+    events_.push_back({name, cat, ts, dur, tid});
+}
+
+std::vector<TraceEvent> TraceRecorder::events() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return events_;
+}
+
+void TraceRecorder::clear() {
+    std::lock_guard<std::mutex> lk(mu_);
+    events_.clear();
+}
+
+static void write_json_string(std::ostream& os, const char* s) {
+    os << '"';
+    for (; s && *s; ++s) {
+        if (*s == '"' || *s == '\\') os << '\\';
+        if (static_cast<unsigned char>(*s) >= 0x20) os << *s;
+    }
+    os << '"';
+}
+
+// ナノ秒をマイクロ秒の固定小数3桁で書く（浮動小数の丸めを避ける）
+static void write_us(std::ostream& os, int64_t ns) {
+    if (ns < 0) ns = 0;
+    const char fill = os.fill('0');
+    os << ns / 1000 << '.' << std::setw(3) << ns % 1000;
+    os.fill(fill);
+}
+
+void TraceRecorder::write_chrome_json(std::ostream& os) const {
+    auto evs = events();
+    std::stable_sort(evs.begin(), evs.end(), [](const TraceEvent& a, const TraceEvent& b) { return a.ts_ns < b.ts_ns; });
+    // ts/dur はマイクロ秒（小数可）
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (size_t i = 0; i < evs.size(); ++i) {
+        const auto& e = evs[i];
+        if (i) os << ',';
+        os << "{\"name\":";
+        write_json_string(os, e.name);
+        os << ",\"cat\":";
+        write_json_string(os, e.cat);
+        os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+           << ",\"ts\":";
+        write_us(os, e.ts_ns);
+        os << ",\"dur\":";
+        write_us(os, e.dur_ns);
+        os << '}';
+    }
+    os << "]}\n";
+}
+
+bool TraceRecorder::save_chrome_json(const std::string& path) const {
+    std::ofstream ofs(path);
+    if (!ofs) return false;
+    write_chrome_json(ofs);
+    return static_cast<bool>(ofs);
+}
+
+// ---- LatencyHistogram ----
+// 値 v < 2S（S = 2^kSubBits）はそのまま添字、それ以上は e = msb(v) - kSubBits として
+// 上位 kSubBits+1 ビット m = v >> e（S <= m < 2S）を使い、添字 S*e + m
+
+// 最大の添字は msb=63 のとき S*(63-kSubBits) + 2S-1
+LatencyHistogram::LatencyHistogram() : counts_((size_t(64 - kSubBits) << kSubBits) + (size_t(1) << kSubBits), 0) {}
+
+// 最上位の1のビット位置（v=0 は 0 とする。clz は 0 で未定義なので先に弾く）
+static inline int msb64(uint64_t v) {
+    if (v == 0) return 0;
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int n = 0;
+    while (v >>= 1) ++n;
+    return n;
+#endif
+}
+
+size_t LatencyHistogram::bucket_of(uint64_t ns) {
+    constexpr uint64_t S = uint64_t(1) << kSubBits;
+    if (ns < 2 * S) return static_cast<size_t>(ns);
+    const int e = msb64(ns) - kSubBits;
+    return static_cast<size_t>(S * static_cast<uint64_t>(e) + (ns >> e));
+}
+
+uint64_t LatencyHistogram::bucket_upper(size_t idx) {
+    constexpr uint64_t S = uint64_t(1) << kSubBits;
+    if (idx < 2 * S) return idx;
+    const int e = static_cast<int>(idx / S) - 1;
+    const uint64_t m = idx - S * static_cast<uint64_t>(e);
+    return ((m + 1) << e) - 1;
+}
+
+void LatencyHistogram::record_ns(uint64_t ns) {
+    ++counts_[bucket_of(ns)];
+    min_ = count_ ? std::min(min_, ns) : ns;
+    max_ = count_ ? std::max(max_, ns) : ns;
+    sum_ += ns;
+    ++count_;
+}
+
+void LatencyHistogram::record(double ms) {
+    record_ns(ms > 0.0 ? static_cast<uint64_t>(std::llround(ms * 1e6)) : 0);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& o) {
+    if (!o.count_) return;
+    for (size_t i = 0; i < counts_.size(); ++i) counts_[i] += o.counts_[i];
+    min_ = count_ ? std::min(min_, o.min_) : o.min_;
+    max_ = count_ ? std::max(max_, o.max_) : o.max_;
+    sum_ += o.sum_;
+    count_ += o.count_;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts_.begin(), counts_.end(), 0);
+    count_ = min_ = max_ = 0;
+    sum_ = 0.0L;
+}
+
+double LatencyHistogram::percentile(double q) const {
+    if (!count_) return 0.0;
+    q = std::min(1.0, std::max(0.0, q));
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= rank) return static_cast<double>(std::min(bucket_upper(i), max_)) / 1e6;
+    }
+    return static_cast<double>(max_) / 1e6;
+}
+
+double LatencyHistogram::min_ms() const { return static_cast<double>(min_) / 1e6; }
+double LatencyHistogram::max_ms() const { return static_cast<double>(max_) / 1e6; }
+double LatencyHistogram::mean_ms() const {
+    return count_ ? static_cast<double>(sum_ / count_) / 1e6 : 0.0;
+}
+
+} // namespace engine
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <vector>
+#include <cmath>
 #include <cstring>
 #include <string>
 
@@ -160,3 +161,178 @@ TEST(CAPI, TruncatedBuffer_EmitsMessage) {
     // メッセージに "truncated" を含む（実装の文言に合わせる）
     ASSERT_NE(std::string(err).find("truncated"), std::string::npos);
 }
+
+TEST(CAPI, OccupancyCost_AvoidsCostlyCells) {
+    const int rows = 5, cols = 7;
+    auto occ = make_grid(rows, cols, 0);
+    for (int c = 0; c < 6; ++c) occ[idx(2,c,cols)] = 40; // 高コストだが通行可能
+
+    uint16_t table[101];
+    for (int v = 0; v <= 100; ++v) table[v] = (v >= 40) ? 20 : 1;
+
+    astar_options_t opts;
+    astar_options_init(&opts);
+    opts.allow_diagonal = 0;
+    opts.cost_mode = ASTAR_COST_OCCUPANCY;
+    opts.cost_table = table;
+
+    std::vector<point_i32> path(64);
+    int len = (int)path.size();
+    double cost = 0.0;
+    auto st = astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 0, 4, &opts,
+                                path.data(), &len, &cost, nullptr, 0);
+    ASSERT_EQ(st, PLAN_OK);
+    EXPECT_DOUBLE_EQ(cost, 16.0);
+    for (int i = 0; i < len; ++i) EXPECT_NE(occ[idx(path[i].y, path[i].x, cols)], 40);
+
+    // NULL オプションは astar_plan_c の既定と同じ
+    len = (int)path.size();
+    st = astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 0, 4, nullptr,
+                           path.data(), &len, &cost, nullptr, 0);
+    ASSERT_EQ(st, PLAN_OK);
+    EXPECT_DOUBLE_EQ(cost, 4.0);
+}
+
+TEST(CAPI, PathMode_AnyAngleAndSmoothed) {
+    const int rows = 10, cols = 10;
+    auto occ = make_grid(rows, cols, 0);
+
+    astar_options_t opts;
+    astar_options_init(&opts);
+    std::vector<point_i32> path(64);
+    double cost = 0.0;
+
+    for (int mode : {ASTAR_PATH_SMOOTHED, ASTAR_PATH_ANY_ANGLE}) {
+        opts.path_mode = mode;
+        int len = (int)path.size();
+        auto st = astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 9, 4, &opts,
+                                    path.data(), &len, &cost, nullptr, 0);
+        ASSERT_EQ(st, PLAN_OK);
+        ASSERT_EQ(len, 2); // 障害物がなければ start と goal だけ
+        EXPECT_EQ(path[1].x, 9);
+        EXPECT_EQ(path[1].y, 4);
+        EXPECT_NEAR(cost, std::sqrt(81.0 + 16.0), 1e-9);
+    }
+
+    opts.cost_mode = ASTAR_COST_OCCUPANCY;
+    int len = (int)path.size();
+    auto st = astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 9, 4, &opts,
+                                path.data(), &len, &cost, nullptr, 0);
+    EXPECT_EQ(st, PLAN_INVALID_ARG);
+}
+
+TEST(CAPI, EncodedPath_DecodesToSameCells) {
+    const int rows = 12, cols = 40;
+    auto occ = make_grid(rows, cols, 0);
+    for (int r = 0; r < 10; ++r) occ[idx(r, 20, cols)] = 100;
+
+    std::vector<point_i32> cells(256);
+    int cells_len = (int)cells.size();
+    double cost_cells = 0.0;
+    ASSERT_EQ(astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 39, 0, nullptr,
+                                cells.data(), &cells_len, &cost_cells, nullptr, 0), PLAN_OK);
+
+    for (int enc : {ASTAR_ENCODING_MOVES, ASTAR_ENCODING_RUNLENGTH}) {
+        // まず必要バイト数だけ問い合わせる
+        int32_t need = 0, steps = -1;
+        ASSERT_EQ(astar_plan_encoded_c(occ.data(), rows, cols, 0, 0, 39, 0, nullptr, enc,
+                                       nullptr, &need, &steps, nullptr, nullptr, 0), PLAN_OK);
+        EXPECT_EQ(steps, cells_len - 1);
+        EXPECT_LT(need, cells_len * (int)sizeof(point_i32));
+
+        std::vector<uint8_t> buf(need);
+        int32_t small = need - 1;
+        char err[64] = {0};
+        EXPECT_EQ(astar_plan_encoded_c(occ.data(), rows, cols, 0, 0, 39, 0, nullptr, enc,
+                                       buf.data(), &small, &steps, nullptr, err, sizeof(err)), PLAN_INVALID_ARG);
+        EXPECT_EQ(small, need);
+
+        int32_t len = need;
+        double cost = 0.0;
+        ASSERT_EQ(astar_plan_encoded_c(occ.data(), rows, cols, 0, 0, 39, 0, nullptr, enc,
+                                       buf.data(), &len, &steps, &cost, nullptr, 0), PLAN_OK);
+        EXPECT_DOUBLE_EQ(cost, cost_cells);
+
+        std::vector<point_i32> dec(steps + 1);
+        ASSERT_EQ(astar_decode_path_c(buf.data(), len, enc, steps, 0, 0, dec.data(), (int32_t)dec.size()), steps + 1);
+        for (int i = 0; i < cells_len; ++i) {
+            EXPECT_EQ(dec[i].x, cells[i].x);
+            EXPECT_EQ(dec[i].y, cells[i].y);
+        }
+        EXPECT_EQ(astar_decode_path_c(buf.data(), len, enc, steps, 0, 0, dec.data(), steps), -1);
+        EXPECT_EQ(astar_decode_path_c(buf.data(), len, enc, INT32_MAX, 0, 0, dec.data(), (int32_t)dec.size()), -1);
+    }
+}
+
+TEST(CAPI, LowMemoryEngines) {
+    const int rows = 30, cols = 30;
+    auto occ = make_grid(rows, cols, 0);
+    for (int r = 0; r < 25; ++r) occ[idx(r, 15, cols)] = 100;
+
+    astar_options_t opts;
+    astar_options_init(&opts);
+    std::vector<point_i32> path(256);
+    int len = (int)path.size();
+    double ref = 0.0, cost = 0.0;
+    ASSERT_EQ(astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 29, 0, &opts,
+                                path.data(), &len, &ref, nullptr, 0), PLAN_OK);
+
+    for (int eng : {ASTAR_ENGINE_FRINGE, ASTAR_ENGINE_IDA}) {
+        opts.engine = eng;
+        opts.memory_budget_bytes = 64 * 1024;
+        len = (int)path.size();
+        ASSERT_EQ(astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 29, 0, &opts,
+                                    path.data(), &len, &cost, nullptr, 0), PLAN_OK);
+        EXPECT_NEAR(cost, ref, 1e-9);
+    }
+
+    // 配列を確保できない予算の A*
+    opts.engine = ASTAR_ENGINE_ASTAR;
+    opts.memory_budget_bytes = 4 * 1024;
+    char err[64] = {0};
+    len = (int)path.size();
+    EXPECT_EQ(astar_plan_opts_c(occ.data(), rows, cols, 0, 0, 29, 0, &opts,
+                                path.data(), &len, &cost, err, sizeof(err)), PLAN_RESOURCE_LIMIT);
+    EXPECT_EQ(len, 0);
+}
+
+TEST(CAPI, RepeatedCallsReuseScratchAcrossMapSizes) {
+    // スレッドごとの作業領域を使い回しても、地図の大きさが変わって結果が変わらないこと
+    auto big = make_grid(40, 40, 0);
+    for (int r = 0; r < 35; ++r) big[idx(r, 20, 40)] = 100;
+    auto small = make_grid(5, 5, 0);
+    std::vector<point_i32> path(256);
+    int len = 0;
+    double cost_big = 0.0, cost_small = 0.0, cost = 0.0;
+    len = (int)path.size();
+    ASSERT_EQ(astar_plan_opts_c(big.data(), 40, 40, 0, 0, 39, 0, nullptr,
+                                path.data(), &len, &cost_big, nullptr, 0), PLAN_OK);
+    const int len_big = len;
+    len = (int)path.size();
+    ASSERT_EQ(astar_plan_opts_c(small.data(), 5, 5, 0, 0, 4, 4, nullptr,
+                                path.data(), &len, &cost_small, nullptr, 0), PLAN_OK);
+    EXPECT_EQ(len, 5);
+    EXPECT_EQ(path[4].x, 4);
+    EXPECT_EQ(path[4].y, 4);
+
+    for (int i = 0; i < 3; ++i) {
+        len = (int)path.size();
+        ASSERT_EQ(astar_plan_opts_c(big.data(), 40, 40, 0, 0, 39, 0, nullptr,
+                                    path.data(), &len, &cost, nullptr, 0), PLAN_OK);
+        EXPECT_EQ(len, len_big);
+        EXPECT_DOUBLE_EQ(cost, cost_big);
+        len = (int)path.size();
+        ASSERT_EQ(astar_plan_opts_c(small.data(), 5, 5, 0, 0, 4, 4, nullptr,
+                                    path.data(), &len, &cost, nullptr, 0), PLAN_OK);
+        EXPECT_DOUBLE_EQ(cost, cost_small);
+    }
+
+    // 作業領域を解放しても次の呼び出しはそのまま動く
+    astar_release_thread_cache();
+    len = (int)path.size();
+    ASSERT_EQ(astar_plan_opts_c(big.data(), 40, 40, 0, 0, 39, 0, nullptr,
+                                path.data(), &len, &cost, nullptr, 0), PLAN_OK);
+    EXPECT_EQ(len, len_big);
+    EXPECT_DOUBLE_EQ(cost, cost_big);
+    astar_release_thread_cache();
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/any_angle.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+// 参照実装：2倍座標で線分と閉じたセル矩形の交差を1セルずつ調べる
+static bool ref_visible(const Grid& g, Cell a, Cell b) {
+    const long x0 = 2*a.c+1, y0 = 2*a.r+1, x1 = 2*b.c+1, y1 = 2*b.r+1;
+    auto side = [&](long x, long y) {
+        long v = (x1-x0)*(y-y0) - (y1-y0)*(x-x0);
+        return (v > 0) - (v < 0);
+    };
+    for (int r = std::min(a.r,b.r); r <= std::max(a.r,b.r); ++r) {
+        for (int c = std::min(a.c,b.c); c <= std::max(a.c,b.c); ++c) {
+            int s[4] = { side(2*c,2*r), side(2*c+2,2*r), side(2*c,2*r+2), side(2*c+2,2*r+2) };
+            bool all_pos = true, all_neg = true;
+            for (int v : s) { all_pos &= (v > 0); all_neg &= (v < 0); }
+            if (!all_pos && !all_neg && g.at(r,c) >= 50) return false;
+        }
+    }
+    return true;
+}
+
+TEST(LineOfSight, MatchesReferenceOnRandomMaps) {
+    std::mt19937 rng(7);
+    for (int cols : {10, 70, 130}) { // ワード境界をまたぐ幅も試す
+        Grid g = open_grid(20, cols);
+        for (auto& v : g.occ) v = (rng() % 8 == 0) ? 100 : 0;
+        LineOfSight los(g, AstarConfig{});
+        for (int i = 0; i < 3000; ++i) {
+            Cell a{static_cast<int>(rng() % 20), static_cast<int>(rng() % cols)};
+            Cell b{static_cast<int>(rng() % 20), static_cast<int>(rng() % cols)};
+            if (g.at(a.r,a.c) >= 50 || g.at(b.r,b.c) >= 50) continue;
+            ASSERT_EQ(los.visible(a, b), ref_visible(g, a, b))
+                << "(" << a.r << "," << a.c << ")-(" << b.r << "," << b.c << ")";
+            ASSERT_EQ(los.visible(a, b), los.visible(b, a));
+        }
+    }
+}
+
+TEST(LineOfSight, DiagonalCornerIsBlocked) {
+    Grid g = open_grid(2, 2);
+    g.occ[1] = 100; // (0,1)
+    LineOfSight los(g, AstarConfig{});
+    EXPECT_FALSE(los.visible({0,0}, {1,1}));
+    EXPECT_TRUE(los.visible({0,0}, {1,0}));
+}
+
+TEST(LazyTheta, StraightLineOnOpenMap) {
+    Grid g = open_grid(30, 30);
+    auto out = lazy_theta_plan_ex(g, {0,0}, {20,29}, AstarConfig{});
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    ASSERT_EQ(out.result->path.size(), 2u);
+    EXPECT_NEAR(out.result->stats.cost, std::hypot(20.0, 29.0), 1e-9);
+}
+
+TEST(LazyTheta, ShorterThanGridPathAndVisible) {
+    std::mt19937 rng(3);
+    for (int trial = 0; trial < 20; ++trial) {
+        Grid g = open_grid(40, 40);
+        for (auto& v : g.occ) v = (rng() % 5 == 0) ? 100 : 0;
+        Cell s{0,0}, t{39,39};
+        g.occ[0] = 0; g.occ.back() = 0;
+        AstarConfig cfg;
+        auto grid = astar_plan_ex(g, s, t, cfg);
+        auto any = lazy_theta_plan_ex(g, s, t, cfg);
+        ASSERT_EQ(grid.status == PlanStatus::Ok, any.status == PlanStatus::Ok);
+        if (grid.status != PlanStatus::Ok) continue;
+        const auto& p = any.result->path;
+        EXPECT_LE(any.result->stats.cost, grid.result->stats.cost + 1e-9);
+        EXPECT_NEAR(any.result->stats.cost, polyline_length(p), 1e-9);
+        LineOfSight los(g, cfg);
+        for (size_t i = 1; i < p.size(); ++i) EXPECT_TRUE(los.visible(p[i-1], p[i]));
+    }
+}
+
+TEST(LazyTheta, Errors) {
+    Grid g = open_grid(5, 5);
+    for (int r = 0; r < 5; ++r) g.occ[r*5 + 2] = 100;
+    EXPECT_EQ(lazy_theta_plan_ex(g, {0,0}, {0,4}, AstarConfig{}).status, PlanStatus::NoPath);
+    EXPECT_EQ(lazy_theta_plan_ex(g, {0,0}, {0,2}, AstarConfig{}).status, PlanStatus::InvalidArg);
+    EXPECT_EQ(lazy_theta_plan_ex(g, {0,0}, {9,9}, AstarConfig{}).status, PlanStatus::OutOfBounds);
+    AstarConfig w;
+    w.cost_mode = CostMode::OccupancyWeighted;
+    EXPECT_EQ(lazy_theta_plan_ex(g, {0,0}, {4,0}, w).status, PlanStatus::InvalidArg);
+}
+
+TEST(SmoothPath, ReducesWaypoints) {
+    Grid g = open_grid(20, 20);
+    for (int r = 0; r < 15; ++r) g.occ[r*20 + 10] = 100; // 縦の壁
+    AstarConfig cfg;
+    auto out = astar_plan_ex(g, {0,0}, {0,19}, cfg);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    auto sm = smooth_path(g, cfg, out.result->path);
+    EXPECT_LT(sm.size(), out.result->path.size());
+    EXPECT_LE(sm.size(), 4u);
+    EXPECT_EQ(sm.front().r, 0); EXPECT_EQ(sm.front().c, 0);
+    EXPECT_EQ(sm.back().r, 0);  EXPECT_EQ(sm.back().c, 19);
+    EXPECT_LE(polyline_length(sm), out.result->stats.cost + 1e-9);
+    LineOfSight los(g, cfg);
+    for (size_t i = 1; i < sm.size(); ++i) EXPECT_TRUE(los.visible(sm[i-1], sm[i]));
+}
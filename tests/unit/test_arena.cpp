@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/arena.hpp"
+#include "test_util.hpp"
+
+// 定常状態の確保回数を数えるため operator new を差し替える
+static thread_local uint64_t t_allocs = 0;
+
+void* operator new(std::size_t n) {
+    ++t_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+using namespace engine;
+using namespace test_util;
+
+TEST(Arena, AlignmentAndReset) {
+    QueryArena arena;
+    void* a = arena.allocate(3, 1);
+    void* b = arena.allocate(8, 8);
+    void* c = arena.allocate(32, 32);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 8, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 32, 0u);
+    EXPECT_NE(a, b);
+    EXPECT_GE(arena.used(), 3u + 8u + 32u);
+    EXPECT_EQ(arena.upstream_allocations(), 1u);
+
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_EQ(arena.allocate(3, 1), a); // 先頭から使い直す
+}
+
+TEST(Arena, ChunksCoalesceOnReset) {
+    QueryArena arena(1024);
+    for (int i = 0; i < 10; ++i) ASSERT_NE(arena.allocate(40 * 1024, 16), nullptr);
+    const size_t cap = arena.capacity();
+    EXPECT_GE(cap, 400u * 1024);
+    EXPECT_GT(arena.upstream_allocations(), 2u);
+
+    // reset で1チャンクにまとまれば、同じ量を確保しても上流へは行かない
+    arena.reset();
+    const uint64_t ups = arena.upstream_allocations();
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 10; ++i) ASSERT_NE(arena.allocate(40 * 1024, 16), nullptr);
+        arena.reset();
+    }
+    EXPECT_EQ(arena.upstream_allocations(), ups);
+    EXPECT_EQ(arena.capacity(), cap);
+
+    // release でチャンクを全て返し、次の確保でまた取る
+    arena.release();
+    EXPECT_EQ(arena.capacity(), 0u);
+    EXPECT_EQ(arena.used(), 0u);
+    ASSERT_NE(arena.allocate(100, 8), nullptr);
+    EXPECT_EQ(arena.upstream_allocations(), ups + 1);
+}
+
+TEST(Arena, PlanIntoMatchesPlanEx) {
+    Grid g = random_grid(48, 48, 5);
+    QueryArena arena;
+    PlanResult out;
+    for (PathFormat fmt : {PathFormat::Cells, PathFormat::Moves, PathFormat::RunLength}) {
+        for (CostMode mode : {CostMode::Uniform, CostMode::OccupancyWeighted}) {
+            AstarConfig cfg;
+            cfg.cost_mode = mode;
+            cfg.path_format = fmt;
+            auto ref = astar_plan_ex(g, {0,0}, {47,47}, cfg);
+            ASSERT_EQ(ref.status, PlanStatus::Ok);
+
+            arena.reset();
+            cfg.memory = &arena;
+            ASSERT_EQ(astar_plan_into(g, {0,0}, {47,47}, cfg, out), PlanStatus::Ok);
+            EXPECT_GT(arena.used(), 0u);
+            EXPECT_DOUBLE_EQ(out.stats.cost, ref.result->stats.cost);
+            EXPECT_EQ(out.stats.expanded, ref.result->stats.expanded);
+            if (fmt == PathFormat::Cells) {
+                ASSERT_EQ(out.path.size(), ref.result->path.size());
+                for (size_t i = 0; i < out.path.size(); ++i) {
+                    EXPECT_EQ(out.path[i].r, ref.result->path[i].r);
+                    EXPECT_EQ(out.path[i].c, ref.result->path[i].c);
+                }
+                EXPECT_FALSE(out.compact.has_value());
+            } else {
+                ASSERT_TRUE(out.compact.has_value());
+                EXPECT_TRUE(out.path.empty());
+                EXPECT_EQ(out.compact->steps, ref.result->compact->steps);
+                EXPECT_EQ(out.compact->data, ref.result->compact->data);
+            }
+        }
+    }
+}
+
+TEST(Arena, PlanIntoFailureStatuses) {
+    Grid g = random_grid(8, 8, 1);
+    for (int c = 0; c < 8; ++c) g.occ[4*8 + c] = 100;
+    PlanResult out;
+    EXPECT_EQ(astar_plan_into(g, {0,0}, {7,7}, AstarConfig{}, out), PlanStatus::NoPath);
+    EXPECT_EQ(astar_plan_into(g, {0,0}, {9,9}, AstarConfig{}, out), PlanStatus::OutOfBounds);
+    EXPECT_EQ(astar_plan_into(g, {0,0}, {4,0}, AstarConfig{}, out), PlanStatus::InvalidArg);
+}
+
+TEST(Arena, SteadyStateHasNoHeapAllocations) {
+    Grid g = random_grid(64, 64, 9);
+    std::mt19937 rng(2);
+    std::vector<std::pair<Cell, Cell>> qs;
+    while (qs.size() < 30) {
+        Cell s{static_cast<int>(rng() % 64), static_cast<int>(rng() % 64)};
+        Cell t{static_cast<int>(rng() % 64), static_cast<int>(rng() % 64)};
+        if (g.at(s.r, s.c) == 0 && g.at(t.r, t.c) == 0) qs.push_back({s, t});
+    }
+    for (PathFormat fmt : {PathFormat::Cells, PathFormat::RunLength}) {
+        QueryArena arena;
+        PlanResult out;
+        AstarConfig cfg;
+        cfg.path_format = fmt;
+        cfg.memory = &arena;
+        auto run_all = [&] {
+            int ok = 0;
+            for (const auto& q : qs) {
+                arena.reset();
+                ok += astar_plan_into(g, q.first, q.second, cfg, out) == PlanStatus::Ok;
+            }
+            return ok;
+        };
+        const int warm = run_all(); // 暖機でアリーナと out を育てる
+        const uint64_t ups = arena.upstream_allocations();
+        const uint64_t before = t_allocs;
+        EXPECT_EQ(run_all(), warm);
+        EXPECT_EQ(t_allocs - before, 0u);
+        EXPECT_EQ(arena.upstream_allocations(), ups);
+    }
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/cooperative.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+static Cell at(const AgentPath& p, int t) {
+    return p.path[std::min<size_t>(t, p.path.size() - 1)];
+}
+
+// 頂点の衝突・すれ違い・移動の妥当性を調べる
+static void expect_conflict_free(const Grid& g, const std::vector<AgentTask>& tasks, const CooperativeResult& res) {
+    int T = 0;
+    for (size_t a = 0; a < tasks.size(); ++a) {
+        const auto& p = res.agents[a];
+        if (p.status != PlanStatus::Ok) continue;
+        expect_valid_path(g, p.path, tasks[a].start, tasks[a].goal);
+        T = std::max(T, static_cast<int>(p.path.size()));
+    }
+    for (int t = 0; t <= T; ++t) {
+        std::map<std::pair<int,int>, size_t> occ;
+        for (size_t a = 0; a < tasks.size(); ++a) {
+            const auto& p = res.agents[a];
+            Cell c = p.status == PlanStatus::Ok ? at(p, t) : tasks[a].start;
+            auto [it, inserted] = occ.insert({{c.r, c.c}, a});
+            EXPECT_TRUE(inserted) << "vertex conflict t=" << t << " agents " << it->second << "," << a;
+        }
+        for (size_t a = 0; a < tasks.size(); ++a) {
+            for (size_t b = a + 1; b < tasks.size(); ++b) {
+                const auto &pa = res.agents[a], &pb = res.agents[b];
+                if (pa.status != PlanStatus::Ok || pb.status != PlanStatus::Ok) continue;
+                Cell a0 = at(pa, t), a1 = at(pa, t + 1), b0 = at(pb, t), b1 = at(pb, t + 1);
+                bool swap = a0.r == b1.r && a0.c == b1.c && a1.r == b0.r && a1.c == b0.c && !(a0.r == a1.r && a0.c == a1.c);
+                EXPECT_FALSE(swap) << "edge swap t=" << t << " agents " << a << "," << b;
+            }
+        }
+    }
+}
+
+TEST(ReservationTable, ReserveAndGrow) {
+    ReservationTable tab;
+    for (int t = 0; t < 100; ++t)
+        for (int c = 0; c < 50; ++c) EXPECT_TRUE(tab.reserve(c, t, c + t));
+    EXPECT_EQ(tab.size(), 5000u);
+    EXPECT_FALSE(tab.reserve(7, 3, 99)); // 既に予約済み
+    EXPECT_EQ(tab.occupant(7, 3), 10);
+    EXPECT_EQ(tab.occupant(49, 99), 148);
+    EXPECT_EQ(tab.occupant(50, 0), -1);
+    EXPECT_EQ(tab.occupant(0, 100), -1);
+    tab.clear();
+    EXPECT_EQ(tab.size(), 0u);
+    EXPECT_EQ(tab.occupant(7, 3), -1);
+}
+
+TEST(Cooperative, HeadOnCorridorUsesPocket) {
+    // 幅1の廊下と、真ん中に1マスの退避所
+    //   #####.####   <- 行0 は (0,5) 以外が壁
+    //   ..........
+    std::vector<Cell> walls;
+    for (int c = 0; c < 10; ++c) if (c != 5) walls.push_back({0, c});
+    Grid g = open_grid(2, 10, walls);
+    std::vector<AgentTask> tasks = {{{1,0}, {1,9}}, {{1,9}, {1,0}}};
+    AstarConfig cfg;
+    cfg.allow_diagonal = false;
+
+    // 独立に計画するとすれ違いで衝突する
+    auto a = astar_plan_ex(g, tasks[0].start, tasks[0].goal, cfg);
+    auto b = astar_plan_ex(g, tasks[1].start, tasks[1].goal, cfg);
+    ASSERT_EQ(a.status, PlanStatus::Ok);
+    ASSERT_EQ(b.status, PlanStatus::Ok);
+    EXPECT_EQ(a.result->path.size(), b.result->path.size());
+
+    auto out = cooperative_plan_ex(g, tasks, cfg);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    ASSERT_TRUE(out.result.has_value());
+    EXPECT_EQ(out.result->stats.planned, 2);
+    expect_conflict_free(g, tasks, *out.result);
+    // 優先度の高い台はまっすぐ進み、もう1台が退避所に入る
+    EXPECT_EQ(out.result->agents[0].path.size(), 10u);
+    bool pocket = false;
+    for (auto c : out.result->agents[1].path) pocket |= (c.r == 0 && c.c == 5);
+    EXPECT_TRUE(pocket);
+}
+
+TEST(Cooperative, SingleAgentMatchesAstarCost) {
+    Grid g = open_grid(20, 20, {{5,5},{5,6},{5,7},{6,7},{7,7},{10,2},{11,2},{12,2}});
+    for (auto mode : {CostMode::Uniform, CostMode::OccupancyWeighted}) {
+        AstarConfig cfg;
+        cfg.cost_mode = mode;
+        auto ref = astar_plan_ex(g, {0,0}, {19,18}, cfg);
+        auto out = cooperative_plan_ex(g, {{{0,0}, {19,18}}}, cfg);
+        ASSERT_EQ(out.status, PlanStatus::Ok);
+        // 斜めは整数コスト 1.414 なので Uniform の √2 とはわずかにずれる
+        EXPECT_NEAR(out.result->agents[0].cost, ref.result->stats.cost, 1e-3 * ref.result->stats.cost);
+    }
+}
+
+TEST(Cooperative, HundredAgentsConflictFree) {
+    std::mt19937 rng(7);
+    Grid g = open_grid(64, 64);
+    for (auto& v : g.occ) if (rng() % 8 == 0) v = 100;
+    std::vector<AgentTask> tasks;
+    std::set<int> starts, goals;
+    while (tasks.size() < 120) {
+        Cell s{static_cast<int>(rng() % 64), static_cast<int>(rng() % 64)};
+        Cell t{static_cast<int>(rng() % 64), static_cast<int>(rng() % 64)};
+        if (g.at(s.r, s.c) || g.at(t.r, t.c)) continue;
+        if (!starts.insert(s.r*64 + s.c).second) continue;
+        if (!goals.insert(t.r*64 + t.c).second) { starts.erase(s.r*64 + s.c); continue; }
+        tasks.push_back({s, t});
+    }
+    AstarConfig cfg;
+    auto out = cooperative_plan_ex(g, tasks, cfg);
+    ASSERT_TRUE(out.result.has_value());
+    const auto& st = out.result->stats;
+    EXPECT_EQ(st.planned + st.failed, 120);
+    EXPECT_GE(st.planned, 110);
+    EXPECT_GT(st.agents_per_sec, 0.0);
+    EXPECT_GT(st.reservations, 120u);
+    expect_conflict_free(g, tasks, *out.result);
+}
+
+TEST(Cooperative, InvalidInputs) {
+    Grid g = open_grid(5, 5, {{2,2}});
+    AstarConfig cfg;
+    EXPECT_EQ(cooperative_plan_ex(g, {{{0,0}, {9,9}}}, cfg).status, PlanStatus::OutOfBounds);
+    EXPECT_EQ(cooperative_plan_ex(g, {{{0,0}, {2,2}}}, cfg).status, PlanStatus::InvalidArg);
+    EXPECT_EQ(cooperative_plan_ex(g, {{{0,0}, {4,4}}, {{0,0}, {4,3}}}, cfg).status, PlanStatus::InvalidArg);
+    auto empty = cooperative_plan_ex(g, {}, cfg);
+    EXPECT_EQ(empty.status, PlanStatus::Ok);
+    EXPECT_TRUE(empty.result->agents.empty());
+}
+
+TEST(Cooperative, SharedGoalFailsLaterAgent) {
+    Grid g = open_grid(5, 5);
+    auto out = cooperative_plan_ex(g, {{{0,0}, {4,4}}, {{0,4}, {4,4}}}, AstarConfig{});
+    EXPECT_EQ(out.status, PlanStatus::NoPath);
+    ASSERT_TRUE(out.result.has_value());
+    EXPECT_EQ(out.result->agents[0].status, PlanStatus::Ok);
+    EXPECT_EQ(out.result->agents[1].status, PlanStatus::NoPath);
+    EXPECT_EQ(out.result->stats.failed, 1);
+    expect_conflict_free(g, {{{0,0}, {4,4}}, {{0,4}, {4,4}}}, *out.result);
+}
+
+TEST(Cooperative, FailedAgentStartIsAvoidedByEarlierAgents) {
+    // 後の台がゴールを取られて失敗し、先の台の通り道の上に留まる
+    AstarConfig cfg;
+    cfg.allow_diagonal = false;
+    const std::vector<AgentTask> tasks = {{{0,0}, {0,4}}, {{0,2}, {0,4}}};
+
+    // 1行の通路では迂回できないので両方失敗し、どちらも動かない
+    Grid line = open_grid(1, 5);
+    auto out = cooperative_plan_ex(line, tasks, cfg);
+    EXPECT_EQ(out.status, PlanStatus::NoPath);
+    ASSERT_TRUE(out.result.has_value());
+    EXPECT_EQ(out.result->stats.failed, 2);
+    expect_conflict_free(line, tasks, *out.result);
+
+    // 2行なら先の台は失敗した台を避けて下の行を通る
+    Grid two = open_grid(2, 5);
+    out = cooperative_plan_ex(two, tasks, cfg);
+    EXPECT_EQ(out.status, PlanStatus::NoPath);
+    ASSERT_TRUE(out.result.has_value());
+    EXPECT_EQ(out.result->agents[0].status, PlanStatus::Ok);
+    EXPECT_EQ(out.result->agents[1].status, PlanStatus::NoPath);
+    EXPECT_EQ(out.result->stats.failed, 1);
+    expect_conflict_free(two, tasks, *out.result);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <queue>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+
+using namespace engine;
+
+// 比較用の素朴な Dijkstra（A* と同じ整数コスト 1000/1414 × 倍率）
+static double dijkstra_cost(const Grid& g, Cell s, Cell t, const OccupancyCostTable& w) {
+    const int N = g.rows * g.cols;
+    std::vector<long long> d(N, std::numeric_limits<long long>::max());
+    using Item = std::pair<long long,int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> pq;
+    d[s.r*g.cols + s.c] = 0;
+    pq.push({0, s.r*g.cols + s.c});
+    auto free_cell = [&](int r, int c){ return g.in(r,c) && g.at(r,c) < 50; };
+    while (!pq.empty()) {
+        auto [dist, id] = pq.top(); pq.pop();
+        if (dist > d[id]) continue;
+        int r = id / g.cols, c = id % g.cols;
+        for (int dr = -1; dr <= 1; ++dr) for (int dc = -1; dc <= 1; ++dc) {
+            if (!dr && !dc) continue;
+            int nr = r + dr, nc = c + dc;
+            if (!free_cell(nr,nc)) continue;
+            if (dr && dc && (!free_cell(r,nc) || !free_cell(nr,c))) continue;
+            long long nd = dist + ((dr && dc) ? 1414 : 1000) * w[g.at(nr,nc)];
+            if (nd < d[nr*g.cols + nc]) { d[nr*g.cols + nc] = nd; pq.push({nd, nr*g.cols + nc}); }
+        }
+    }
+    return d[t.r*g.cols + t.c] / 1000.0;
+}
+
+TEST(OccupancyCost, MatchesDijkstraOnRandomMaps) {
+    unsigned seed = 7;
+    auto rnd = [&]{ seed = seed * 1103515245u + 12345u; return (seed >> 16) & 0x7fff; };
+    AstarConfig cfg;
+    cfg.cost_mode = CostMode::OccupancyWeighted;
+    const auto w = default_occupancy_costs();
+
+    for (int trial = 0; trial < 20; ++trial) {
+        Grid g; g.rows = 20; g.cols = 25;
+        g.occ.resize(g.rows * g.cols);
+        for (auto& v : g.occ) v = (rnd() % 6 == 0) ? 100 : static_cast<uint8_t>(rnd() % 50);
+        g.occ[0] = 0;
+        g.occ.back() = 0;
+        auto out = astar_plan_ex(g, {0,0}, {g.rows-1, g.cols-1}, cfg);
+        double ref = dijkstra_cost(g, {0,0}, {g.rows-1, g.cols-1}, w);
+        if (std::isinf(ref) || ref > 1e15) {
+            EXPECT_EQ(out.status, PlanStatus::NoPath);
+            continue;
+        }
+        ASSERT_EQ(out.status, PlanStatus::Ok);
+        EXPECT_NEAR(out.result->stats.cost, ref, 1e-9);
+    }
+}
+
+TEST(OccupancyCost, AvoidsCostlyCells) {
+    // 中央の行が高コスト（通行可能）な帯
+    Grid g; g.rows = 5; g.cols = 7;
+    g.occ.assign(35, 0);
+    for (int c = 0; c < 6; ++c) g.occ[2*7 + c] = 40;
+
+    AstarConfig cfg{false, Heuristic::Manhattan, 50};
+    auto uni = astar_plan_ex(g, {0,0}, {4,0}, cfg);
+    ASSERT_EQ(uni.status, PlanStatus::Ok);
+    EXPECT_DOUBLE_EQ(uni.result->stats.cost, 4.0);
+
+    cfg.cost_mode = CostMode::OccupancyWeighted;
+    OccupancyCostTable w{};
+    for (int v = 0; v <= 100; ++v) w[v] = (v >= 40) ? 20 : 1;
+    cfg.cost_table = &w;
+    auto weighted = astar_plan_ex(g, {0,0}, {4,0}, cfg);
+    ASSERT_EQ(weighted.status, PlanStatus::Ok);
+    // 高コストの帯を避けて右端の列を回る
+    for (const auto& p : weighted.result->path) EXPECT_NE(g.at(p.r, p.c), 40);
+    EXPECT_DOUBLE_EQ(weighted.result->stats.cost, 16.0);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/cpd.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+namespace fs = std::filesystem;
+
+TEST(Cpd, MatchesAstarForAllPairs) {
+    Grid g = random_grid(12, 14, 3, 4);
+    AstarConfig cfg;
+    auto db = build_cpd(g, cfg, 4);
+    ASSERT_TRUE(db.has_value());
+    EXPECT_GT(db->stats.bytes, 0u);
+    EXPECT_EQ(db->stats.threads, 4);
+
+    for (int s = 0; s < g.rows * g.cols; ++s) {
+        for (int t = 0; t < g.rows * g.cols; t += 3) {
+            Cell cs{s / g.cols, s % g.cols}, ct{t / g.cols, t % g.cols};
+            auto ref = astar_plan_ex(g, cs, ct, cfg);
+            auto got = cpd_plan_ex(*db, cs, ct);
+            ASSERT_EQ(got.status, ref.status) << s << "->" << t;
+            if (ref.status != PlanStatus::Ok) continue;
+            EXPECT_NEAR(got.result->stats.cost, ref.result->stats.cost, 1e-9);
+            EXPECT_EQ(got.result->stats.expanded, 0);
+            expect_valid_path(g, got.result->path, cs, ct);
+        }
+    }
+}
+
+TEST(Cpd, SaveAndLoad) {
+    Grid g = random_grid(10, 10, 9, 4);
+    g.occ[0] = 0; g.occ[99] = 0;
+    AstarConfig cfg{false, Heuristic::Manhattan, 50};
+    auto db = build_cpd(g, cfg, 1);
+    ASSERT_TRUE(db.has_value());
+
+    fs::path dir = fs::temp_directory_path() / "a_star_finder_tests";
+    fs::create_directories(dir);
+    std::string path = (dir / "map.cpd").string();
+    ASSERT_TRUE(save_cpd(*db, path));
+    auto loaded = load_cpd(path, g, cfg);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->fingerprint, db->fingerprint);
+    EXPECT_EQ(loaded->runs, db->runs);
+    EXPECT_EQ(loaded->stats.bytes, db->stats.bytes);
+
+    auto a = cpd_plan_ex(*db, {0,0}, {9,9});
+    auto b = cpd_plan_ex(*loaded, {0,0}, {9,9});
+    EXPECT_EQ(a.status, b.status);
+
+    EXPECT_FALSE(load_cpd("/this/path/does/not/exist.cpd", g, cfg).has_value());
+
+    // 大きさが同じでも地図や設定が違えば読まない
+    Grid moved = g;
+    moved.occ[1] = moved.occ[1] ? 0 : 100;
+    EXPECT_FALSE(load_cpd(path, moved, cfg).has_value());
+    AstarConfig other = cfg;
+    other.allow_diagonal = true;
+    EXPECT_FALSE(load_cpd(path, g, other).has_value());
+    other = cfg;
+    other.block_threshold = 101;
+    EXPECT_FALSE(load_cpd(path, g, other).has_value());
+    other = cfg;
+    other.inflation_radius = 1.0f;
+    EXPECT_FALSE(load_cpd(path, g, other).has_value());
+}
+
+TEST(Cpd, LoadRejectsCorruptRuns) {
+    Grid g = random_grid(8, 8, 4, 4);
+    g.occ[0] = 0;
+    auto db = build_cpd(g, AstarConfig{}, 1);
+    ASSERT_TRUE(db.has_value());
+    ASSERT_GT(db->offsets[1], 0u); // セル0（通れる）はランを持つ
+
+    fs::path dir = fs::temp_directory_path() / "a_star_finder_tests";
+    fs::create_directories(dir);
+    const std::string path = (dir / "corrupt.cpd").string();
+    auto loads = [&](const CompressedPathDb& d) { return save_cpd(d, path) && load_cpd(path, g, AstarConfig{}).has_value(); };
+    EXPECT_TRUE(loads(*db));
+
+    // 先頭のランが位置0から始まらない
+    CompressedPathDb bad = *db;
+    bad.runs[0] |= 1u << 4;
+    EXPECT_FALSE(loads(bad));
+
+    // ランを持たない source（同じ成分に他のセルがある）
+    bad = *db;
+    const uint32_t n0 = bad.offsets[1];
+    bad.runs.erase(bad.runs.begin(), bad.runs.begin() + n0);
+    for (auto& o : bad.offsets) o = o >= n0 ? o - n0 : 0;
+    EXPECT_FALSE(loads(bad));
+
+    // ランの位置が増えていない
+    bad = *db;
+    for (size_t s = 0; s + 1 < bad.offsets.size(); ++s) {
+        if (bad.offsets[s + 1] - bad.offsets[s] < 2) continue;
+        bad.runs[bad.offsets[s] + 1] &= 0xF; // 2番目のランを位置0に
+        break;
+    }
+    EXPECT_FALSE(loads(bad));
+}
+
+TEST(Cpd, RejectsUnsupportedConfig) {
+    Grid g = random_grid(4, 4, 1, 4);
+    AstarConfig cfg;
+    cfg.cost_mode = CostMode::OccupancyWeighted;
+    EXPECT_FALSE(build_cpd(g, cfg).has_value());
+    EXPECT_FALSE(build_cpd(Grid{}, AstarConfig{}).has_value());
+}
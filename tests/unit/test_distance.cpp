@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include "engine/grid.hpp"
+#include "engine/distance.hpp"
+#include "engine/astar.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+// 総当たりの距離（比較用）
+static float brute(const Grid& g, int r, int c) {
+    float best = std::numeric_limits<float>::infinity();
+    for (int rr = 0; rr < g.rows; ++rr)
+        for (int cc = 0; cc < g.cols; ++cc)
+            if (g.at(rr,cc) >= 50) best = std::min(best, std::hypot(float(rr - r), float(cc - c)));
+    return best;
+}
+
+TEST(DistanceField, MatchesBruteForce) {
+    Grid g = open_grid(23, 31);
+    unsigned s = 12345;
+    for (auto& v : g.occ) { s = s * 1103515245u + 12345u; v = ((s >> 16) % 13 == 0) ? 100 : 0; }
+
+    for (int threads : {1, 4}) {
+        auto df = compute_distance_field(g, 50, threads);
+        ASSERT_EQ(df.rows, g.rows);
+        ASSERT_EQ(df.cols, g.cols);
+        for (int r = 0; r < g.rows; ++r)
+            for (int c = 0; c < g.cols; ++c)
+                EXPECT_NEAR(df.at(r,c), brute(g, r, c), 1e-4) << r << "," << c;
+    }
+}
+
+TEST(DistanceField, NoObstacleIsInfinite) {
+    auto df = compute_distance_field(open_grid(3, 4));
+    for (float d : df.dist) EXPECT_TRUE(std::isinf(d));
+}
+
+TEST(DistanceField, InflationBlocksNarrowGap) {
+    // 幅3セルの隙間がある壁
+    Grid g = open_grid(9, 9);
+    for (int c = 0; c < 9; ++c) if (c < 3 || c > 5) g.occ[4*9 + c] = 100;
+
+    auto df = compute_distance_field(g);
+    AstarConfig cfg;
+    cfg.distance_field = &df;
+
+    auto thin = astar_plan_ex(g, {0,4}, {8,4}, cfg);
+    ASSERT_EQ(thin.status, PlanStatus::Ok);
+
+    cfg.inflation_radius = 1.0f; // 隙間の中央列だけ残る
+    auto r1 = astar_plan_ex(g, {0,4}, {8,4}, cfg);
+    ASSERT_EQ(r1.status, PlanStatus::Ok);
+    for (const auto& p : r1.result->path) EXPECT_GT(df.at(p.r, p.c), 1.0f);
+
+    cfg.inflation_radius = 2.0f; // 隙間が塞がる
+    EXPECT_EQ(astar_plan_ex(g, {0,4}, {8,4}, cfg).status, PlanStatus::NoPath);
+
+    // 単位がメートルのときは resolution で換算
+    g.resolution = 0.5f;
+    cfg.inflation_radius = 1.0f;
+    cfg.inflation_unit = RadiusUnit::Meters;
+    EXPECT_EQ(astar_plan_ex(g, {0,4}, {8,4}, cfg).status, PlanStatus::NoPath);
+
+    // キャッシュなしでも同じ結果
+    cfg.distance_field = nullptr;
+    cfg.inflation_radius = 1.0f;
+    cfg.inflation_unit = RadiusUnit::Cells;
+    EXPECT_EQ(astar_plan_ex(g, {0,4}, {8,4}, cfg).status, PlanStatus::Ok);
+
+    // start が膨張領域内
+    EXPECT_EQ(astar_plan_ex(g, {3,0}, {8,4}, cfg).status, PlanStatus::InvalidArg);
+}
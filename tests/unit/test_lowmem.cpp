@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+TEST(LowMemory, SameCostAsAstar) {
+    for (unsigned seed = 0; seed < 8; ++seed) {
+        Grid g = random_grid(24, 30, seed, 4, 40);
+        for (bool diag : {true, false}) {
+            for (auto mode : {CostMode::Uniform, CostMode::OccupancyWeighted}) {
+                AstarConfig cfg;
+                cfg.allow_diagonal = diag;
+                cfg.heuristic = diag ? Heuristic::Octile : Heuristic::Manhattan;
+                cfg.cost_mode = mode;
+                auto ref = astar_plan_ex(g, {0,0}, {23,29}, cfg);
+                for (auto eng : {SearchEngine::Fringe, SearchEngine::IdaStar}) {
+                    cfg.engine = eng;
+                    auto out = astar_plan_ex(g, {0,0}, {23,29}, cfg);
+                    ASSERT_EQ(out.status, ref.status) << "seed " << seed;
+                    if (out.status != PlanStatus::Ok) continue;
+                    EXPECT_NEAR(out.result->stats.cost, ref.result->stats.cost, 1e-9);
+                    EXPECT_GT(out.result->stats.peak_bytes, 0u);
+                    expect_valid_path(g, out.result->path, {0,0}, {23,29});
+                }
+                cfg.engine = SearchEngine::AStar;
+            }
+        }
+    }
+}
+
+TEST(LowMemory, FringeUsesLessMemoryThanAstar) {
+    Grid g; g.rows = 400; g.cols = 400;
+    g.occ.assign(static_cast<size_t>(g.rows) * g.cols, 0);
+    AstarConfig cfg;
+    auto a = astar_plan_ex(g, {0,0}, {10,399}, cfg);
+    cfg.engine = SearchEngine::Fringe;
+    cfg.memory_budget_bytes = 256 * 1024;
+    auto f = astar_plan_ex(g, {0,0}, {10,399}, cfg);
+    ASSERT_EQ(a.status, PlanStatus::Ok);
+    ASSERT_EQ(f.status, PlanStatus::Ok);
+    EXPECT_NEAR(f.result->stats.cost, a.result->stats.cost, 1e-9);
+    EXPECT_LE(f.result->stats.peak_bytes, cfg.memory_budget_bytes);
+    EXPECT_LT(f.result->stats.peak_bytes * 5, a.result->stats.peak_bytes);
+
+    // 同じ予算では A* は配列を確保できない
+    cfg.engine = SearchEngine::AStar;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {10,399}, cfg).status, PlanStatus::ResourceLimit);
+}
+
+TEST(LowMemory, IdaRespectsBudget) {
+    Grid g = random_grid(20, 20, 5, 4, 40);
+    AstarConfig cfg;
+    auto ref = astar_plan_ex(g, {0,0}, {19,19}, cfg);
+    ASSERT_EQ(ref.status, PlanStatus::Ok);
+    cfg.engine = SearchEngine::IdaStar;
+
+    cfg.memory_budget_bytes = 64 * 1024;
+    auto big = astar_plan_ex(g, {0,0}, {19,19}, cfg);
+    cfg.memory_budget_bytes = 2 * 1024;
+    auto small = astar_plan_ex(g, {0,0}, {19,19}, cfg);
+    ASSERT_EQ(big.status, PlanStatus::Ok);
+    ASSERT_EQ(small.status, PlanStatus::Ok);
+    EXPECT_NEAR(small.result->stats.cost, ref.result->stats.cost, 1e-9);
+    EXPECT_LE(small.result->stats.peak_bytes, 2u * 1024);
+    EXPECT_GE(small.result->stats.expanded, big.result->stats.expanded);
+
+    cfg.memory_budget_bytes = 64;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {19,19}, cfg).status, PlanStatus::ResourceLimit);
+}
+
+TEST(LowMemory, NoPathAndCancel) {
+    Grid g; g.rows = 5; g.cols = 5;
+    g.occ.assign(25, 0);
+    for (int r = 0; r < 5; ++r) g.occ[r*5 + 2] = 100;
+    std::atomic<bool> flag{true};
+    for (auto eng : {SearchEngine::Fringe, SearchEngine::IdaStar}) {
+        AstarConfig cfg;
+        cfg.engine = eng;
+        EXPECT_EQ(astar_plan_ex(g, {0,0}, {0,4}, cfg).status, PlanStatus::NoPath);
+        auto same = astar_plan_ex(g, {1,1}, {1,1}, cfg);
+        ASSERT_EQ(same.status, PlanStatus::Ok);
+        EXPECT_EQ(same.result->path.size(), 1u);
+        cfg.cancel = &flag;
+        EXPECT_EQ(astar_plan_ex(g, {0,0}, {4,1}, cfg).status, PlanStatus::Cancelled);
+    }
+}
+
+TEST(LowMemory, IdaUnreachableGoalWithSmallBudget) {
+    // 置換表が小さいと閾値を上げる反復が終わらなくなる配置（ゴールを壁で囲む）
+    Grid g = random_grid(24, 24, 3, 4, 40);
+    g.occ[22*24 + 22] = 100; g.occ[22*24 + 23] = 100; g.occ[23*24 + 22] = 100;
+    AstarConfig cfg;
+    cfg.engine = SearchEngine::IdaStar;
+    cfg.memory_budget_bytes = 2048;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {23,23}, cfg).status, PlanStatus::NoPath);
+    // 塗りつぶしのビットマップも予算に入る
+    cfg.memory_budget_bytes = 96;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {23,23}, cfg).status, PlanStatus::ResourceLimit);
+}
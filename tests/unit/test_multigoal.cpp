@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/multigoal.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+// 比較用の単一ゴールのヒューリスティック
+static double hcost_ref(int r, int c, Cell t, Heuristic h) {
+    double dr = std::abs(t.r - r), dc = std::abs(t.c - c);
+    switch (h) {
+        case Heuristic::Manhattan: return dr + dc;
+        case Heuristic::Euclidean: return std::hypot(dr, dc);
+        case Heuristic::Octile: break;
+    }
+    return std::max(dr, dc) + (std::sqrt(2.0) - 1.0) * std::min(dr, dc);
+}
+
+TEST(MultiGoal, HeuristicIsMinimumOverGoals) {
+    std::vector<Cell> goals;
+    for (int i = 0; i < 200; ++i) goals.push_back({(i * 37) % 97, (i * 53) % 89});
+    GoalSet flat(goals, -1);   // バケットなし
+    GoalSet bucketed(goals);   // 自動でバケット化
+    EXPECT_FALSE(flat.bucketed());
+    EXPECT_TRUE(bucketed.bucketed());
+
+    for (auto h : {Heuristic::Manhattan, Heuristic::Euclidean, Heuristic::Octile}) {
+        for (int r = 0; r < 100; r += 7) for (int c = 0; c < 90; c += 11) {
+            double ref = 1e18;
+            for (const auto& t : goals) ref = std::min(ref, hcost_ref(r, c, t, h));
+            EXPECT_NEAR(flat.min_heuristic(r, c, h), ref, 1e-3);
+            EXPECT_NEAR(bucketed.min_heuristic(r, c, h), ref, 1e-3);
+            EXPECT_LE(bucketed.min_heuristic(r, c, h), ref);
+        }
+    }
+}
+
+TEST(MultiGoal, MatchesBestSingleGoalQuery) {
+    AstarConfig cfg;
+    for (unsigned seed = 1; seed <= 10; ++seed) {
+        Grid g = random_grid(30, 30, seed);
+        g.occ[0] = 0;
+        std::vector<Cell> goals = {{29,29}, {0,29}, {29,0}, {15,15}, {5,20}};
+        double best = 1e18;
+        for (const auto& t : goals) {
+            auto o = astar_plan_ex(g, {0,0}, t, cfg);
+            if (o.status == PlanStatus::Ok) best = std::min(best, o.result->stats.cost);
+        }
+        auto m = astar_plan_multi_ex(g, {0,0}, goals, cfg);
+        if (best >= 1e18) {
+            EXPECT_NE(m.status, PlanStatus::Ok);
+            continue;
+        }
+        ASSERT_EQ(m.status, PlanStatus::Ok);
+        EXPECT_NEAR(m.result->stats.cost, best, 1e-9);
+        ASSERT_GE(m.goal_index, 0);
+        const Cell t = goals[m.goal_index];
+        EXPECT_EQ(m.result->path.back().r, t.r);
+        EXPECT_EQ(m.result->path.back().c, t.c);
+    }
+}
+
+TEST(MultiGoal, WeightedPicksNearestGoal) {
+    // 斜め 1.414 の重み付きで、Octile の √2 を使うと (100,100) を過大評価して遠い方を選んでしまう配置
+    Grid g; g.rows = 150; g.cols = 150;
+    g.occ.assign(150 * 150, 0);
+    AstarConfig cfg;
+    cfg.cost_mode = CostMode::OccupancyWeighted;
+    const std::vector<Cell> goals = {{100,100}, {1,141}};
+    double best = 1e18;
+    int best_i = -1;
+    for (int i = 0; i < static_cast<int>(goals.size()); ++i) {
+        auto o = astar_plan_ex(g, {0,0}, goals[i], cfg);
+        ASSERT_EQ(o.status, PlanStatus::Ok);
+        if (o.result->stats.cost < best) { best = o.result->stats.cost; best_i = i; }
+    }
+    auto m = astar_plan_multi_ex(g, {0,0}, goals, cfg);
+    ASSERT_EQ(m.status, PlanStatus::Ok);
+    EXPECT_EQ(m.goal_index, best_i);
+    EXPECT_NEAR(m.result->stats.cost, best, 1e-9);
+}
+
+TEST(MultiGoal, SkipsBlockedGoalsAndReportsIndex) {
+    Grid g; g.rows = 3; g.cols = 5;
+    g.occ = {0,0,0,0,100,
+             0,0,0,0,0,
+             0,0,0,0,0};
+    AstarConfig cfg;
+    auto m = astar_plan_multi_ex(g, {1,0}, {{0,4}, {2,4}, {1,3}}, cfg);
+    ASSERT_EQ(m.status, PlanStatus::Ok);
+    EXPECT_EQ(m.goal_index, 2);
+    EXPECT_DOUBLE_EQ(m.result->stats.cost, 3.0);
+
+    EXPECT_EQ(astar_plan_multi_ex(g, {1,0}, {{0,4}}, cfg).status, PlanStatus::InvalidArg);
+    EXPECT_EQ(astar_plan_multi_ex(g, {1,0}, {}, cfg).status, PlanStatus::InvalidArg);
+    EXPECT_EQ(astar_plan_multi_ex(g, {1,0}, {{5,5}}, cfg).status, PlanStatus::OutOfBounds);
+}
+
+TEST(MultiGoal, HeuristicHandlesTailsAndSparseGoals) {
+    // 4レーンに割り切れない個数と、広い範囲にまばらに散ったゴール
+    for (int n : {1, 3, 5, 33, 101}) {
+        std::vector<Cell> goals;
+        for (int i = 0; i < n; ++i) goals.push_back({(i * 7919) % 2000, (i * 104729) % 1500});
+        GoalSet flat(goals, -1), bucketed(goals);
+        EXPECT_EQ(bucketed.bucketed(), n > 32);
+        for (auto h : {Heuristic::Manhattan, Heuristic::Euclidean, Heuristic::Octile}) {
+            for (int r = 0; r < 2000; r += 199) for (int c = 0; c < 1500; c += 149) {
+                double ref = 1e18;
+                for (const auto& t : goals) ref = std::min(ref, hcost_ref(r, c, t, h));
+                EXPECT_NEAR(flat.min_heuristic(r, c, h), ref, 1e-6 * ref + 1e-3);
+                EXPECT_NEAR(bucketed.min_heuristic(r, c, h), ref, 1e-6 * ref + 1e-3);
+                EXPECT_LE(bucketed.min_heuristic(r, c, h), ref);
+            }
+        }
+    }
+}
+
+TEST(MultiGoal, Cancel) {
+    Grid g = random_grid(40, 40, 2);
+    g.occ[0] = 0;
+    std::vector<Cell> goals;
+    for (int i = 0; i < 100; ++i) goals.push_back({39, (i * 13) % 40});
+    std::atomic<bool> flag{true};
+    AstarConfig cfg;
+    cfg.cancel = &flag;
+    EXPECT_EQ(astar_plan_multi_ex(g, {0,0}, goals, cfg).status, PlanStatus::Cancelled);
+    // 中断中でも下界のまま（途中で打ち切ったバケットがあれば 0）
+    GoalSet gs(goals);
+    EXPECT_LE(gs.min_heuristic(0, 0, Heuristic::Octile, GoalSet::kOctileK, &flag),
+              gs.min_heuristic(0, 0, Heuristic::Octile));
+}
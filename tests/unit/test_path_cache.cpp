@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/path_cache.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+TEST(PathCache, ExactAndSubpathHits) {
+    Grid g = open_grid(10, 10);
+    AstarConfig cfg{false, Heuristic::Manhattan, 50};
+    PathCache cache(1 << 20);
+
+    auto first = cached_plan_ex(cache, g, {0,0}, {0,9}, cfg);
+    ASSERT_EQ(first.status, PlanStatus::Ok);
+    EXPECT_EQ(cache.stats().misses, 1u);
+    EXPECT_EQ(cache.stats().entries, 1u);
+
+    auto again = cached_plan_ex(cache, g, {0,0}, {0,9}, cfg);
+    ASSERT_EQ(again.status, PlanStatus::Ok);
+    EXPECT_EQ(cache.stats().hits, 1u);
+    EXPECT_EQ(again.result->stats.expanded, 0);
+    EXPECT_DOUBLE_EQ(again.result->stats.cost, first.result->stats.cost);
+
+    // 部分経路（順方向・逆方向）
+    auto sub = cache.find(g, cfg, {0,2}, {0,7});
+    ASSERT_TRUE(sub.has_value());
+    EXPECT_DOUBLE_EQ(sub->stats.cost, 5.0);
+    EXPECT_EQ(sub->path.front().c, 2);
+    EXPECT_EQ(sub->path.back().c, 7);
+    auto rev = cache.find(g, cfg, {0,7}, {0,2});
+    ASSERT_TRUE(rev.has_value());
+    EXPECT_EQ(rev->path.front().c, 7);
+    EXPECT_EQ(rev->path.back().c, 2);
+    EXPECT_EQ(cache.stats().subpath_hits, 2u);
+
+    // 設定や地図の版が違えばヒットしない
+    AstarConfig diag = cfg;
+    diag.allow_diagonal = true;
+    EXPECT_FALSE(cache.find(g, diag, {0,2}, {0,7}).has_value());
+    Grid g2 = g;
+    g2.version = 1;
+    EXPECT_FALSE(cache.find(g2, cfg, {0,2}, {0,7}).has_value());
+}
+
+TEST(PathCache, WeightedPathsAreNotReversed) {
+    Grid g = open_grid(1, 6);
+    for (int c = 0; c < 6; ++c) g.occ[c] = static_cast<uint8_t>(c * 5);
+    AstarConfig cfg{false, Heuristic::Manhattan, 50};
+    cfg.cost_mode = CostMode::OccupancyWeighted;
+    PathCache cache(1 << 20);
+
+    auto out = cached_plan_ex(cache, g, {0,0}, {0,5}, cfg);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    auto sub = cache.find(g, cfg, {0,1}, {0,4});
+    ASSERT_TRUE(sub.has_value());
+    auto ref = astar_plan_ex(g, {0,1}, {0,4}, cfg);
+    EXPECT_DOUBLE_EQ(sub->stats.cost, ref.result->stats.cost);
+    EXPECT_FALSE(cache.find(g, cfg, {0,4}, {0,1}).has_value());
+}
+
+TEST(PathCache, InvalidateRegionAndEvict) {
+    Grid g = open_grid(10, 10);
+    AstarConfig cfg{false, Heuristic::Manhattan, 50};
+    PathCache cache(1 << 20);
+    cached_plan_ex(cache, g, {0,0}, {0,9}, cfg);
+    cached_plan_ex(cache, g, {9,0}, {9,9}, cfg);
+    EXPECT_EQ(cache.stats().entries, 2u);
+
+    EXPECT_EQ(cache.invalidate_region(0, 4, 1, 5), 1u);
+    EXPECT_EQ(cache.stats().invalidated, 1u);
+    EXPECT_FALSE(cache.find(g, cfg, {0,0}, {0,9}).has_value());
+    EXPECT_TRUE(cache.find(g, cfg, {9,0}, {9,9}).has_value());
+
+    // 1件分しか入らない容量では古いものから追い出す
+    PathCache tiny(cache.stats().bytes + 1);
+    cached_plan_ex(tiny, g, {0,0}, {0,9}, cfg);
+    cached_plan_ex(tiny, g, {5,0}, {5,9}, cfg);
+    EXPECT_EQ(tiny.stats().entries, 1u);
+    EXPECT_EQ(tiny.stats().evictions, 1u);
+    EXPECT_TRUE(tiny.find(g, cfg, {5,0}, {5,9}).has_value());
+}
+
+TEST(PathCache, InvalidateCornerCutAndInflatedNeighbours) {
+    // 斜め移動 (0,0)->(1,1) の脇のセル (0,1) は経路上にないが、塞がれば角の通り抜けで使えない
+    Grid g = open_grid(3, 3);
+    AstarConfig cfg{true, Heuristic::Octile, 50};
+    PathCache cache(1 << 20);
+    auto out = cached_plan_ex(cache, g, {0,0}, {2,2}, cfg);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    ASSERT_EQ(out.result->path.size(), 3u);
+    EXPECT_EQ(cache.invalidate_region(0, 1, 0, 1), 1u);
+    EXPECT_FALSE(cache.find(g, cfg, {0,0}, {2,2}).has_value());
+
+    // 膨張半径の内側に置かれた障害物も経路を無効にする
+    Grid h = open_grid(10, 10);
+    AstarConfig inf{false, Heuristic::Manhattan, 50};
+    inf.inflation_radius = 2.0f;
+    ASSERT_EQ(cached_plan_ex(cache, h, {0,0}, {0,9}, inf).status, PlanStatus::Ok);
+    EXPECT_EQ(cache.invalidate_region(4, 5, 4, 5), 0u); // 1 + 2 セルより遠い
+    EXPECT_EQ(cache.invalidate_region(3, 5, 3, 5), 1u);
+}
+
+TEST(PathCache, ConcurrentQueries) {
+    Grid g = open_grid(20, 20);
+    AstarConfig cfg;
+    PathCache cache(1 << 16);
+    std::vector<std::thread> th;
+    for (int t = 0; t < 4; ++t) {
+        th.emplace_back([&, t] {
+            for (int i = 0; i < 200; ++i) {
+                Cell s{(i + t) % 20, 0}, goal{19 - (i % 20), 19};
+                auto out = cached_plan_ex(cache, g, s, goal, cfg);
+                EXPECT_EQ(out.status, PlanStatus::Ok);
+            }
+        });
+    }
+    for (auto& x : th) x.join();
+    auto st = cache.stats();
+    EXPECT_EQ(st.hits + st.subpath_hits + st.misses, 800u);
+    EXPECT_LE(st.bytes, static_cast<size_t>(1 << 16));
+}
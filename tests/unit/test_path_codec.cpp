@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include <limits>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/path_cache.hpp"
+#include "engine/pyramid.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+static void expect_same(const std::vector<Cell>& a, const std::vector<Cell>& b) {
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT_EQ(a[i].r, b[i].r);
+        EXPECT_EQ(a[i].c, b[i].c);
+    }
+}
+
+TEST(PathCodec, RoundTripAndSize) {
+    // 32 を超える直進を含む経路
+    std::vector<Cell> path;
+    for (int c = 0; c <= 40; ++c) path.push_back({0, c});
+    for (int k = 1; k <= 5; ++k) path.push_back({k, 40 + k});
+    path.push_back({4, 45});
+
+    auto mv = encode_path(path, PathFormat::Moves);
+    ASSERT_TRUE(mv.has_value());
+    EXPECT_EQ(mv->steps, 46);
+    EXPECT_EQ(mv->data.size(), (3u * 46 + 7) / 8);
+    expect_same(decode_path(*mv), path);
+
+    auto rl = encode_path(path, PathFormat::RunLength);
+    ASSERT_TRUE(rl.has_value());
+    EXPECT_EQ(rl->data.size(), 4u); // 32 + 8 右, 5 斜め, 1 上
+    expect_same(decode_path(*rl), path);
+
+    // 1点だけ・隣接しない点を含む
+    auto one = encode_path({{3,3}}, PathFormat::Moves);
+    ASSERT_TRUE(one.has_value());
+    EXPECT_EQ(one->steps, 0);
+    expect_same(decode_path(*one), {{3,3}});
+    EXPECT_FALSE(encode_path({{0,0},{0,2}}, PathFormat::Moves).has_value());
+    EXPECT_FALSE(encode_path(path, PathFormat::Cells).has_value());
+
+    // 壊れたデータは空
+    CompactPath bad = *mv;
+    bad.data.pop_back();
+    EXPECT_TRUE(decode_path(bad).empty());
+    // steps が壊れていても巨大な確保をせずに空を返す
+    for (const auto* cp : {&*mv, &*rl}) {
+        bad = *cp;
+        bad.steps = std::numeric_limits<int32_t>::max();
+        EXPECT_TRUE(decode_path(bad).empty());
+    }
+    bad = *rl; // RunLength は回数の合計と steps が一致すること
+    bad.steps += 1;
+    EXPECT_TRUE(decode_path(bad).empty());
+}
+
+TEST(PathCodec, AstarEmitsCompactFromParents) {
+    for (unsigned seed = 0; seed < 10; ++seed) {
+        Grid g = random_grid(40, 50, seed, 6, 40);
+        for (auto mode : {CostMode::Uniform, CostMode::OccupancyWeighted}) {
+            AstarConfig cfg;
+            cfg.cost_mode = mode;
+            auto cells = astar_plan_ex(g, {0,0}, {39,49}, cfg);
+            for (auto fmt : {PathFormat::Moves, PathFormat::RunLength}) {
+                cfg.path_format = fmt;
+                auto enc = astar_plan_ex(g, {0,0}, {39,49}, cfg);
+                ASSERT_EQ(enc.status, cells.status);
+                if (enc.status != PlanStatus::Ok) continue;
+                EXPECT_TRUE(enc.result->path.empty());
+                ASSERT_TRUE(enc.result->compact.has_value());
+                EXPECT_EQ(enc.result->compact->format, fmt);
+                EXPECT_DOUBLE_EQ(enc.result->stats.cost, cells.result->stats.cost);
+                expect_same(decode_path(*enc.result->compact), cells.result->path);
+            }
+        }
+    }
+}
+
+TEST(PathCodec, PyramidAndCacheHonourFormat) {
+    Grid g = random_grid(64, 64, 42, 6, 40);
+    AstarConfig cfg;
+    cfg.path_format = PathFormat::RunLength;
+    auto pyr = build_pyramid(g, 2, 4);
+    auto po = pyramid_plan_ex(pyr, {0,0}, {63,63}, cfg);
+    ASSERT_EQ(po.status, PlanStatus::Ok);
+    ASSERT_TRUE(po.result->compact.has_value());
+    EXPECT_EQ(decode_path(*po.result->compact).size(), static_cast<size_t>(po.result->compact->steps) + 1);
+
+    PathCache cache(1 << 20);
+    auto first = cached_plan_ex(cache, g, {0,0}, {63,63}, cfg);
+    auto again = cached_plan_ex(cache, g, {0,0}, {63,63}, cfg);
+    ASSERT_EQ(again.status, PlanStatus::Ok);
+    EXPECT_EQ(cache.stats().hits, 1u);
+    ASSERT_TRUE(again.result->compact.has_value());
+    expect_same(decode_path(*again.result->compact), decode_path(*first.result->compact));
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/pyramid.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+TEST(Pyramid, BuildConservative) {
+    Grid g = open_grid(4, 5);
+    g.occ[1*5 + 1] = 60;
+    auto p = build_pyramid(g, 3, 2, DownsampleRule::AnyBlocked, 50);
+    ASSERT_EQ(p.levels.size(), 3u);
+    EXPECT_EQ(p.levels[1].rows, 2);
+    EXPECT_EQ(p.levels[1].cols, 3); // 端数列もまとめる
+    EXPECT_EQ(p.levels[1].at(0,0), 100);
+    EXPECT_EQ(p.levels[1].at(1,2), 0);
+
+    auto pm = build_pyramid(g, 2, 2, DownsampleRule::MaxOccupancy);
+    EXPECT_EQ(pm.levels[1].at(0,0), 60);
+}
+
+TEST(Pyramid, CorridorSearchShrinksOpenList) {
+    // 中央に縦の壁（上下に抜け道）
+    Grid g = open_grid(64, 64);
+    for (int r = 8; r < 56; ++r) g.occ[r*64 + 32] = 100;
+
+    AstarConfig cfg;
+    auto full = astar_plan_ex(g, {32,2}, {32,61}, cfg);
+    ASSERT_EQ(full.status, PlanStatus::Ok);
+
+    auto p = build_pyramid(g, 3, 2);
+    auto out = pyramid_plan_ex(p, {32,2}, {32,61}, cfg);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    ASSERT_TRUE(out.result.has_value());
+    expect_valid_path(g, out.result->path, {32,2}, {32,61});
+    EXPECT_FALSE(out.pyramid.fallback);
+    EXPECT_LT(out.pyramid.corridor_cells, out.pyramid.total_cells);
+    EXPECT_LT(out.result->stats.expanded, full.result->stats.expanded);
+    EXPECT_GE(out.result->stats.cost, full.result->stats.cost - 1e-9);
+}
+
+TEST(Pyramid, FallbackWhenCoarseLevelBlocked) {
+    // 1セル幅の隙間は保守的な粗いグリッドでは塞がる
+    Grid g = open_grid(8, 8);
+    for (int r = 0; r < 8; ++r) if (r != 4) g.occ[r*8 + 4] = 100;
+    for (int r = 0; r < 8; ++r) g.occ[r*8 + 5] = (r == 4) ? 0 : 100;
+
+    auto p = build_pyramid(g, 2, 2);
+    AstarConfig cfg;
+    auto out = pyramid_plan_ex(p, {0,0}, {7,7}, cfg);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+    EXPECT_TRUE(out.pyramid.fallback);
+    expect_valid_path(g, out.result->path, {0,0}, {7,7});
+
+    PyramidConfig strict;
+    strict.fallback_full = false;
+    auto none = pyramid_plan_ex(p, {0,0}, {7,7}, cfg, strict);
+    EXPECT_EQ(none.status, PlanStatus::NoPath);
+}
+
+TEST(Pyramid, InvalidInputs) {
+    Grid g = open_grid(8, 8);
+    g.occ[0] = 100;
+    auto p = build_pyramid(g, 2, 2);
+    AstarConfig cfg;
+    EXPECT_EQ(pyramid_plan_ex(p, {0,0}, {7,7}, cfg).status, PlanStatus::InvalidArg);
+    EXPECT_EQ(pyramid_plan_ex(p, {1,1}, {8,8}, cfg).status, PlanStatus::OutOfBounds);
+    EXPECT_EQ(pyramid_plan_ex(GridPyramid{}, {1,1}, {2,2}, cfg).status, PlanStatus::MapError);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/realtime.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+
+// U字の壁（ゴール側が開いていない袋小路）
+static Grid trap_grid() {
+    std::vector<Cell> walls;
+    for (int r = 5; r <= 20; ++r) walls.push_back({r, 20});
+    for (int c = 8; c <= 20; ++c) { walls.push_back({5, c}); walls.push_back({20, c}); }
+    return open_grid(30, 30, walls);
+}
+
+struct Trip { bool reached; double cost; int ticks; int max_expanded; };
+
+// start からゴールまで tick を繰り返して進む
+static Trip run_trip(RealtimeAgent& agent, const Grid& g, Cell start, int max_ticks = 10000) {
+    Trip trip{false, 0.0, 0, 0};
+    Cell cur = start;
+    for (; trip.ticks < max_ticks; ++trip.ticks) {
+        auto step = agent.tick(cur);
+        EXPECT_EQ(step.status, PlanStatus::Ok);
+        trip.max_expanded = std::max(trip.max_expanded, step.expanded);
+        if (step.at_goal) { trip.reached = true; break; }
+        if (step.status != PlanStatus::Ok || step.moves.empty()) break;
+        for (Cell n : step.moves) {
+            EXPECT_LE(std::max(std::abs(n.r - cur.r), std::abs(n.c - cur.c)), 1);
+            EXPECT_LT(g.at(n.r, n.c), 50);
+            trip.cost += (n.r != cur.r && n.c != cur.c) ? 1.414 : 1.0;
+            cur = n;
+        }
+    }
+    return trip;
+}
+
+TEST(Realtime, PerTickExpansionsBounded) {
+    Grid g = trap_grid();
+    RealtimeConfig rcfg;
+    rcfg.lookahead = 16;
+    rcfg.max_moves = 1;
+    RealtimeAgent agent(g, {12, 28}, AstarConfig{}, rcfg);
+    auto trip = run_trip(agent, g, {12, 10});
+    EXPECT_TRUE(trip.reached);
+    EXPECT_LE(trip.max_expanded, 16);
+    EXPECT_GT(agent.learned_cells(), 0u);
+    EXPECT_GT(agent.table_bytes(), 0u);
+}
+
+TEST(Realtime, ConvergesToOptimalOverTrips) {
+    Grid g = trap_grid();
+    auto ref = astar_plan_ex(g, {12, 10}, {12, 28}, AstarConfig{});
+    ASSERT_EQ(ref.status, PlanStatus::Ok);
+
+    RealtimeConfig rcfg;
+    rcfg.lookahead = 8;
+    RealtimeAgent agent(g, {12, 28}, AstarConfig{}, rcfg);
+    double first = 0.0, last = 0.0;
+    for (int trial = 0; trial < 100; ++trial) {
+        auto trip = run_trip(agent, g, {12, 10});
+        ASSERT_TRUE(trip.reached);
+        if (trial == 0) first = trip.cost;
+        last = trip.cost;
+    }
+    EXPECT_GT(first, last);
+    // 斜めは整数コスト 1.414 なので √2 とはわずかにずれる
+    EXPECT_NEAR(last, ref.result->stats.cost, 1e-3 * ref.result->stats.cost);
+}
+
+TEST(Realtime, FullLookaheadIsOptimal) {
+    std::mt19937 rng(3);
+    Grid g = open_grid(24, 24);
+    for (auto& v : g.occ) if (rng() % 5 == 0) v = 100;
+    g.occ.front() = 0; g.occ.back() = 0;
+    auto ref = astar_plan_ex(g, {0,0}, {23,23}, AstarConfig{});
+    ASSERT_EQ(ref.status, PlanStatus::Ok);
+
+    RealtimeConfig rcfg;
+    rcfg.lookahead = 24 * 24;
+    rcfg.max_moves = 0;
+    RealtimeAgent agent(g, {23,23}, AstarConfig{}, rcfg);
+    auto trip = run_trip(agent, g, {0,0});
+    ASSERT_TRUE(trip.reached);
+    EXPECT_EQ(trip.ticks, 1);
+    EXPECT_NEAR(trip.cost, ref.result->stats.cost, 1e-3 * ref.result->stats.cost);
+}
+
+TEST(Realtime, UnreachableGoalIsNoPath) {
+    // ゴールを壁で囲む（到達できる 91 セルが先読みに収まれば1回で分かる）
+    Grid g = open_grid(10, 10, {{6,6},{6,7},{6,8},{7,6},{8,6},{7,8},{8,8},{8,7}});
+    RealtimeConfig rcfg;
+    rcfg.lookahead = 128;
+    RealtimeAgent agent(g, {7,7}, AstarConfig{}, rcfg);
+    auto step = agent.tick({0,0});
+    EXPECT_EQ(step.status, PlanStatus::NoPath);
+    EXPECT_LE(step.expanded, 91);
+    // 学習表に残るので、別の位置からでもすぐ分かる
+    step = agent.tick({3,3});
+    EXPECT_EQ(step.status, PlanStatus::NoPath);
+    EXPECT_EQ(step.expanded, 0);
+}
+
+TEST(Realtime, InvalidInputsAndGoalChange) {
+    Grid g = open_grid(5, 5, {{2,2}});
+    RealtimeAgent agent(g, {4,4});
+    EXPECT_EQ(agent.tick({9,9}).status, PlanStatus::OutOfBounds);
+    EXPECT_EQ(agent.tick({2,2}).status, PlanStatus::InvalidArg);
+    auto at = agent.tick({4,4});
+    EXPECT_EQ(at.status, PlanStatus::Ok);
+    EXPECT_TRUE(at.at_goal);
+
+    EXPECT_EQ(agent.tick({0,0}).status, PlanStatus::Ok);
+    agent.set_goal({0,4});
+    EXPECT_EQ(agent.learned_cells(), 0u);
+    EXPECT_EQ(agent.goal().c, 4);
+}
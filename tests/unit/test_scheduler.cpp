@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/scheduler.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+using Clock = PlanScheduler::Clock;
+using namespace std::chrono_literals;
+
+TEST(Cancel, AstarStopsWhenFlagIsSet) {
+    Grid g = open_grid(50, 50);
+    std::atomic<bool> flag{true};
+    AstarConfig cfg;
+    cfg.cancel = &flag;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {49,49}, cfg).status, PlanStatus::Cancelled);
+    cfg.cost_mode = CostMode::OccupancyWeighted;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {49,49}, cfg).status, PlanStatus::Cancelled);
+    flag = false;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {49,49}, cfg).status, PlanStatus::Ok);
+}
+
+TEST(Cancel, AstarStopsAtDeadline) {
+    Grid g = open_grid(50, 50);
+    AstarConfig cfg;
+    cfg.deadline = Clock::now() - 1ms;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {49,49}, cfg).status, PlanStatus::Cancelled);
+    cfg.deadline = Clock::now() + 10s;
+    EXPECT_EQ(astar_plan_ex(g, {0,0}, {49,49}, cfg).status, PlanStatus::Ok);
+}
+
+TEST(Scheduler, ResultsMatchBlockingCall) {
+    Grid g = open_grid(30, 30);
+    PlanScheduler sched(SchedulerConfig{4, true});
+    std::vector<std::future<PlanOutcome>> futs;
+    for (int i = 0; i < 20; ++i) {
+        PlanQuery q{&g, {0,0}, {i, 29}, AstarConfig{}};
+        futs.push_back(sched.submit(q, QueryPriority::Normal, Clock::now() + 10s));
+    }
+    for (int i = 0; i < 20; ++i) {
+        auto out = futs[i].get();
+        ASSERT_EQ(out.status, PlanStatus::Ok);
+        EXPECT_DOUBLE_EQ(out.result->stats.cost, astar_plan_ex(g, {0,0}, {i,29}, AstarConfig{}).result->stats.cost);
+    }
+    auto st = sched.stats().per_class[static_cast<int>(QueryPriority::Normal)];
+    EXPECT_EQ(st.submitted, 20u);
+    EXPECT_EQ(st.completed, 20u);
+}
+
+TEST(Scheduler, EarliestDeadlineFirstAndCancel) {
+    // ゴールに届かない大きな地図で長時間ワーカーを塞ぐ
+    Grid big = open_grid(1500, 1500);
+    for (int r = 0; r < big.rows; ++r) big.occ[r*big.cols + 1400] = 100;
+    Grid small = open_grid(10, 10);
+
+    PlanScheduler sched(SchedulerConfig{1, false});
+    std::atomic<bool> stop_blocker{false};
+    PlanQuery blocker{&big, {0,0}, {0,1499}, AstarConfig{}};
+    blocker.cfg.cancel = &stop_blocker;
+    auto fb = sched.submit(blocker, QueryPriority::Background, Clock::now() + 60s);
+    while (sched.pending() > 0) std::this_thread::yield();
+
+    auto now = Clock::now();
+    PlanQuery q{&small, {0,0}, {9,9}, AstarConfig{}};
+    auto f_bg  = sched.submit(q, QueryPriority::Background, now + 300ms);
+    auto f_nm  = sched.submit(q, QueryPriority::Normal, now + 200ms);
+    auto f_urg = sched.submit(q, QueryPriority::Urgent, now + 100ms);
+    EXPECT_EQ(sched.pending(), 3u);
+    stop_blocker = true;
+
+    EXPECT_EQ(fb.get().status, PlanStatus::Cancelled);
+    EXPECT_EQ(f_urg.get().status, PlanStatus::Ok);
+    EXPECT_EQ(f_nm.get().status, PlanStatus::Ok);
+    EXPECT_EQ(f_bg.get().status, PlanStatus::Ok);
+
+    // 1スレッドなので、締切の早いものほど待ち時間が短い
+    auto st = sched.stats();
+    const auto& urg = st.per_class[static_cast<int>(QueryPriority::Urgent)];
+    const auto& nm = st.per_class[static_cast<int>(QueryPriority::Normal)];
+    const auto& bg = st.per_class[static_cast<int>(QueryPriority::Background)];
+    EXPECT_LE(urg.wait_ms_total, nm.wait_ms_total);
+    EXPECT_LE(nm.wait_ms_total, bg.wait_ms_total); // 中断した blocker は待ち時間に含まれない
+    EXPECT_EQ(bg.submitted, 2u);
+    EXPECT_EQ(bg.cancelled, 1u);
+    EXPECT_EQ(bg.completed, 1u);
+}
+
+TEST(Scheduler, CancelledAndExpiredQueriesDoNotRun) {
+    Grid g = open_grid(10, 10);
+    PlanScheduler sched(SchedulerConfig{2, true});
+
+    std::atomic<bool> flag{true};
+    PlanQuery q{&g, {0,0}, {9,9}, AstarConfig{}};
+    q.cfg.cancel = &flag;
+    EXPECT_EQ(sched.submit(q, QueryPriority::Urgent, Clock::now() + 10s).get().status, PlanStatus::Cancelled);
+
+    PlanQuery late{&g, {0,0}, {9,9}, AstarConfig{}};
+    EXPECT_EQ(sched.submit(late, QueryPriority::Normal, Clock::now() - 1ms).get().status, PlanStatus::Cancelled);
+
+    PlanQuery no_grid;
+    EXPECT_EQ(sched.submit(no_grid, QueryPriority::Normal, Clock::now() + 10s).get().status, PlanStatus::MapError);
+
+    auto st = sched.stats();
+    EXPECT_EQ(st.per_class[0].cancelled, 1u);
+    EXPECT_EQ(st.per_class[0].completed, 0u);
+    EXPECT_EQ(st.per_class[1].cancelled, 1u);
+}
+
+TEST(Scheduler, RunningQueryIsAbortedAtDeadline) {
+    // ゴールに届かない大きな地図：締切までに終わらないクエリ
+    Grid big = open_grid(1500, 1500);
+    for (int r = 0; r < big.rows; ++r) big.occ[r*big.cols + 1400] = 100;
+    PlanScheduler sched(SchedulerConfig{1, true});
+
+    PlanQuery q{&big, {0,0}, {0,1499}, AstarConfig{}};
+    const auto t0 = Clock::now();
+    auto out = sched.submit(q, QueryPriority::Normal, t0 + 20ms).get();
+    const auto took = Clock::now() - t0;
+    EXPECT_EQ(out.status, PlanStatus::Cancelled);
+    EXPECT_LT(took, 2s); // 探索を最後まで回さずに返る
+
+    auto st = sched.stats().per_class[static_cast<int>(QueryPriority::Normal)];
+    EXPECT_EQ(st.cancelled, 1u);
+    EXPECT_EQ(st.deadline_missed, 1u);
+    EXPECT_EQ(st.completed, 0u);
+}
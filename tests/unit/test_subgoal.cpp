@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/subgoal.hpp"
+#include "test_util.hpp"
+
+using namespace engine;
+using namespace test_util;
+namespace fs = std::filesystem;
+
+// セル列の長さ（斜め √2）
+static double path_length(const std::vector<Cell>& path) {
+    double len = 0.0;
+    for (size_t i = 1; i < path.size(); ++i)
+        len += (path[i].r != path[i-1].r && path[i].c != path[i-1].c) ? std::sqrt(2.0) : 1.0;
+    return len;
+}
+
+TEST(SubgoalGraph, OptimalOnRandomMaps) {
+    for (bool diag : {true, false}) {
+        for (unsigned seed = 1; seed <= 4; ++seed) {
+            Grid g = random_grid(16, 18, seed, 4);
+            AstarConfig cfg;
+            cfg.allow_diagonal = diag;
+            cfg.heuristic = diag ? Heuristic::Octile : Heuristic::Manhattan;
+            auto sg = build_subgoal_graph(g, cfg, 2);
+            ASSERT_TRUE(sg.has_value());
+            EXPECT_GT(sg->stats.subgoals, 0);
+
+            for (int s = 0; s < g.rows * g.cols; s += 7) {
+                for (int t = 0; t < g.rows * g.cols; t += 5) {
+                    Cell cs{s / g.cols, s % g.cols}, ct{t / g.cols, t % g.cols};
+                    auto ref = astar_plan_ex(g, cs, ct, cfg);
+                    auto got = subgoal_plan_ex(*sg, g, cs, ct);
+                    ASSERT_EQ(got.status, ref.status) << s << "->" << t;
+                    if (ref.status != PlanStatus::Ok) continue;
+                    EXPECT_NEAR(got.result->stats.cost, ref.result->stats.cost, 1e-9) << s << "->" << t;
+                    const auto& p = got.result->path;
+                    expect_valid_path(g, p, cs, ct);
+                    EXPECT_NEAR(path_length(p), got.result->stats.cost, 1e-9) << s << "->" << t;
+                }
+            }
+        }
+    }
+}
+
+TEST(SubgoalGraph, SaveAndLoad) {
+    Grid g = random_grid(12, 12, 5, 4);
+    g.occ[0] = 0; g.occ.back() = 0;
+    AstarConfig cfg;
+    auto sg = build_subgoal_graph(g, cfg);
+    ASSERT_TRUE(sg.has_value());
+
+    fs::path dir = fs::temp_directory_path() / "a_star_finder_tests";
+    fs::create_directories(dir);
+    std::string path = (dir / "map.ssg").string();
+    ASSERT_TRUE(save_subgoal_graph(*sg, path));
+    auto loaded = load_subgoal_graph(path, g);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->fingerprint, sg->fingerprint);
+    EXPECT_EQ(loaded->edges, sg->edges);
+    EXPECT_EQ(loaded->id_of, sg->id_of);
+
+    auto a = subgoal_plan_ex(*sg, g, {0,0}, {11,11});
+    auto b = subgoal_plan_ex(*loaded, g, {0,0}, {11,11});
+    ASSERT_EQ(a.status, b.status);
+    if (a.status == PlanStatus::Ok) {
+        EXPECT_DOUBLE_EQ(a.result->stats.cost, b.result->stats.cost);
+    }
+
+    Grid other = random_grid(5, 5, 1, 4);
+    EXPECT_EQ(subgoal_plan_ex(*sg, other, {0,0}, {1,1}).status, PlanStatus::MapError);
+
+    // 大きさが同じでも占有率が変わった地図では読まない
+    Grid moved = g;
+    moved.occ[5] = moved.occ[5] ? 0 : 100;
+    EXPECT_FALSE(load_subgoal_graph(path, moved).has_value());
+    // 設定（ここでは閾値）の違いも指紋に入る
+    AstarConfig strict = cfg;
+    strict.block_threshold = 10;
+    auto sg2 = build_subgoal_graph(g, strict);
+    ASSERT_TRUE(sg2.has_value());
+    EXPECT_NE(sg2->fingerprint, sg->fingerprint);
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <sstream>
+#include <string>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/trace.hpp"
+
+using namespace engine;
+
+static Grid open_grid(int rows, int cols) {
+    Grid g; g.rows = rows; g.cols = cols;
+    g.occ.assign(static_cast<size_t>(rows) * cols, 0);
+    return g;
+}
+
+TEST(Trace, DisabledRecordsNothing) {
+    TraceRecorder rec;
+    set_trace_recorder(nullptr);
+    Grid g = open_grid(20, 20);
+    ASSERT_EQ(astar_plan_ex(g, {0,0}, {19,19}, AstarConfig{}).status, PlanStatus::Ok);
+    EXPECT_TRUE(rec.events().empty());
+}
+
+TEST(Trace, RecordsQueryPhases) {
+    TraceRecorder rec;
+    set_trace_recorder(&rec);
+    Grid g = open_grid(20, 20);
+    auto out = astar_plan_ex(g, {0,0}, {19,19}, AstarConfig{});
+    set_trace_recorder(nullptr);
+    ASSERT_EQ(out.status, PlanStatus::Ok);
+
+    auto evs = rec.events();
+    std::set<std::string> names;
+    for (const auto& e : evs) names.insert(e.name);
+    EXPECT_EQ(names, (std::set<std::string>{"plan", "preprocess", "search", "reconstruct"}));
+
+    // 各区間は plan の中に収まる
+    auto plan = std::find_if(evs.begin(), evs.end(), [](const TraceEvent& e) { return std::string(e.name) == "plan"; });
+    ASSERT_NE(plan, evs.end());
+    for (const auto& e : evs) {
+        EXPECT_GE(e.dur_ns, 0);
+        EXPECT_GE(e.ts_ns, plan->ts_ns);
+        EXPECT_LE(e.ts_ns + e.dur_ns, plan->ts_ns + plan->dur_ns);
+    }
+}
+
+TEST(Trace, ChromeJson) {
+    TraceRecorder rec;
+    auto t0 = TraceRecorder::Clock::now();
+    rec.add("search", "planner", t0, t0 + std::chrono::microseconds(1500));
+    std::ostringstream os;
+    rec.write_chrome_json(os);
+    const std::string s = os.str();
+    EXPECT_NE(s.find("\"traceEvents\":["), std::string::npos);
+    EXPECT_NE(s.find("\"name\":\"search\""), std::string::npos);
+    EXPECT_NE(s.find("\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(s.find("\"dur\":1500.000"), std::string::npos);
+
+    rec.clear();
+    EXPECT_TRUE(rec.events().empty());
+}
+
+TEST(LatencyHistogram, PercentilesWithinRelativeError) {
+    LatencyHistogram h;
+    // 1us .. 10ms を一様に
+    for (int i = 1; i <= 10000; ++i) h.record_ns(static_cast<uint64_t>(i) * 1000);
+    EXPECT_EQ(h.count(), 10000u);
+    EXPECT_DOUBLE_EQ(h.min_ms(), 0.001);
+    EXPECT_DOUBLE_EQ(h.max_ms(), 10.0);
+    EXPECT_NEAR(h.mean_ms(), 5.0005, 1e-9);
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        const double exact = q * 10.0;
+        EXPECT_GE(h.percentile(q), exact);
+        EXPECT_LE(h.percentile(q), exact * (1.0 + 1.0 / 128));
+    }
+    EXPECT_DOUBLE_EQ(h.percentile(1.0), 10.0);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+    LatencyHistogram h;
+    for (uint64_t v = 0; v < 256; ++v) h.record_ns(v);
+    EXPECT_DOUBLE_EQ(h.percentile(0.0), 0.0);
+    EXPECT_DOUBLE_EQ(h.percentile(0.5), 127e-6);
+    EXPECT_DOUBLE_EQ(h.percentile(1.0), 255e-6);
+}
+
+TEST(LatencyHistogram, PowerOfTwoBoundaries) {
+    // 2のべきの前後で指数が切り替わっても相対誤差の範囲に収まる
+    for (int e = 9; e < 48; ++e) {
+        const double v = std::ldexp(1.0, e);
+        LatencyHistogram h;
+        h.record_ns((uint64_t(1) << e) - 1);
+        h.record_ns(uint64_t(1) << e);
+        EXPECT_NEAR(h.percentile(0.0) * 1e6, v - 1, v / 128) << e;
+        EXPECT_NEAR(h.percentile(1.0) * 1e6, v, v / 128) << e;
+    }
+}
+
+TEST(LatencyHistogram, MergeAndReset) {
+    LatencyHistogram a, b;
+    for (int i = 0; i < 99; ++i) a.record(1.0);
+    b.record(100.0);
+    a.merge(b);
+    EXPECT_EQ(a.count(), 100u);
+    EXPECT_NEAR(a.percentile(0.5), 1.0, 1.0 / 128);
+    EXPECT_NEAR(a.percentile(0.999), 100.0, 100.0 / 128);
+    EXPECT_DOUBLE_EQ(a.max_ms(), 100.0);
+
+    a.reset();
+    EXPECT_EQ(a.count(), 0u);
+    EXPECT_DOUBLE_EQ(a.percentile(0.5), 0.0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+// 単体テスト共通の地図の作り方と経路の検査
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+
+namespace test_util {
+
+// 障害物のない地図（walls のセルだけ塞ぐ）
+inline engine::Grid open_grid(int rows, int cols, const std::vector<engine::Cell>& walls = {}) {
+    engine::Grid g; g.rows = rows; g.cols = cols;
+    g.occ.assign(static_cast<size_t>(rows) * cols, 0);
+    for (auto w : walls) g.occ[w.r*cols + w.c] = 100;
+    return g;
+}
+
+// 1/obstacle_every の割合で障害物(100)を置いた地図（seed が同じなら同じ地図）
+// max_occ > 0 なら通れるセルに 0..max_occ-1 の占有率を混ぜる。左上と右下のセルは必ず通れる
+inline engine::Grid random_grid(int rows, int cols, unsigned seed, int obstacle_every = 5, int max_occ = 0) {
+    std::mt19937 rng(seed);
+    engine::Grid g = open_grid(rows, cols);
+    for (auto& v : g.occ) {
+        if (rng() % obstacle_every == 0) v = 100;
+        else if (max_occ > 0) v = static_cast<uint8_t>(rng() % max_occ);
+    }
+    g.occ.front() = 0; g.occ.back() = 0;
+    return g;
+}
+
+// s から t まで隣接セルで繋がり、障害物を通らず、斜めで角を抜けない（両脇も通れる）こと
+// 同じセルに留まる手（協調探索の待機）は許す
+inline void expect_valid_path(const engine::Grid& g, const std::vector<engine::Cell>& path,
+                              engine::Cell s, engine::Cell t, int block_threshold = 50) {
+    ASSERT_FALSE(path.empty());
+    EXPECT_EQ(path.front().r, s.r); EXPECT_EQ(path.front().c, s.c);
+    EXPECT_EQ(path.back().r, t.r);  EXPECT_EQ(path.back().c, t.c);
+    for (size_t i = 0; i < path.size(); ++i) {
+        ASSERT_TRUE(g.in(path[i].r, path[i].c));
+        EXPECT_LT(g.at(path[i].r, path[i].c), block_threshold);
+        if (i == 0) continue;
+        const int dr = path[i].r - path[i-1].r, dc = path[i].c - path[i-1].c;
+        EXPECT_LE(std::abs(dr), 1);
+        EXPECT_LE(std::abs(dc), 1);
+        if (dr && dc) {
+            EXPECT_LT(g.at(path[i-1].r, path[i].c), block_threshold) << "corner cut at " << i;
+            EXPECT_LT(g.at(path[i].r, path[i-1].c), block_threshold) << "corner cut at " << i;
+        }
+    }
+}
+
+} // namespace test_util
@@ -0,0 +1,192 @@
+// A* 1クエリあたりのヒープ確保回数と時間を測るベンチマーク
+//   astar_bench [--csv map.csv] [--size N] [--queries Q] [--threads T] [--seed S] [--no-diag]
+// 各モードでクエリ列を一度流して暖めてから、同じクエリ列をもう一度流して測る
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "engine/grid.hpp"
+#include "engine/astar.hpp"
+#include "engine/arena.hpp"
+#include "engine/trace.hpp"
+#include "astar_c.h"
+
+// ---- operator new を差し替えてスレッドごとに確保回数を数える ----
+static thread_local uint64_t t_allocs = 0;
+
+static void* counted_alloc(std::size_t n) {
+    ++t_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+static void* counted_alloc(std::size_t n, std::align_val_t al) {
+    ++t_allocs;
+    const std::size_t a = static_cast<std::size_t>(al);
+    if (void* p = std::aligned_alloc(a, (n + a - 1) / a * a)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t n) { return counted_alloc(n); }
+void* operator new[](std::size_t n) { return counted_alloc(n); }
+void* operator new(std::size_t n, std::align_val_t al) { return counted_alloc(n, al); }
+void* operator new[](std::size_t n, std::align_val_t al) { return counted_alloc(n, al); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+using namespace engine;
+
+struct Query { Cell s, g; };
+
+static void usage() {
+    std::cerr << "Usage: astar_bench [--csv map.csv] [--size N] [--queries Q] [--threads T] [--seed S] [--no-diag]\n";
+}
+
+// 20% を障害物にしたランダムな地図
+static Grid random_grid(int n, std::mt19937& rng) {
+    Grid g; g.rows = n; g.cols = n;
+    g.occ.assign(static_cast<size_t>(n) * n, 0);
+    for (auto& v : g.occ) if (rng() % 5 == 0) v = 100;
+    return g;
+}
+
+enum class Mode { Heap, Arena, CApi };
+
+struct ThreadResult {
+    uint64_t allocs = 0;
+    uint64_t queries = 0;
+    uint64_t ok = 0;
+    LatencyHistogram hist;
+};
+
+// 1スレッド分：暖めてから測る
+static void run_thread(Mode mode, const Grid& g, const std::vector<int32_t>& occ32,
+                       const std::vector<Query>& qs, bool diag, ThreadResult& out) {
+    AstarConfig cfg;
+    cfg.allow_diagonal = diag;
+    astar_options_t opts;
+    astar_options_init(&opts);
+    opts.allow_diagonal = diag ? 1 : 0;
+    opts.block_threshold = cfg.block_threshold;
+    PlanResult buf;
+    std::vector<point_i32> cbuf(g.occ.size());
+
+    auto one = [&](const Query& q) -> bool {
+        switch (mode) {
+        case Mode::Heap:
+            return astar_plan_ex(g, q.s, q.g, cfg).status == PlanStatus::Ok;
+        case Mode::Arena: {
+            QueryArena& arena = thread_query_arena();
+            arena.reset();
+            AstarConfig c = cfg;
+            c.memory = &arena;
+            return astar_plan_into(g, q.s, q.g, c, buf) == PlanStatus::Ok;
+        }
+        case Mode::CApi: {
+            int32_t len = static_cast<int32_t>(cbuf.size());
+            return astar_plan_opts_c(occ32.data(), g.rows, g.cols, q.s.c, q.s.r, q.g.c, q.g.r, &opts,
+                                     cbuf.data(), &len, nullptr, nullptr, 0) == PLAN_OK;
+        }
+        }
+        return false;
+    };
+
+    for (const auto& q : qs) one(q); // 暖機（アリーナや出力バッファを最大規模まで育てる）
+
+    const uint64_t a0 = t_allocs;
+    for (const auto& q : qs) {
+        const auto t0 = std::chrono::steady_clock::now();
+        const bool ok = one(q);
+        const auto t1 = std::chrono::steady_clock::now();
+        out.hist.record_ns(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+        out.ok += ok;
+    }
+    out.allocs = t_allocs - a0;
+    out.queries = qs.size();
+}
+
+int main(int argc, char** argv) {
+    std::string csv;
+    int size = 256, queries = 200, threads = 1;
+    unsigned seed = 1;
+    bool diag = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+        if (a == "--no-diag") { diag = false; continue; }
+        if (a == "--help" || a == "-h") { usage(); return 0; }
+        if (!(v = next())) { usage(); return 2; }
+        if (a == "--csv") csv = v;
+        else if (a == "--size") size = std::atoi(v);
+        else if (a == "--queries") queries = std::atoi(v);
+        else if (a == "--threads") threads = std::atoi(v);
+        else if (a == "--seed") seed = static_cast<unsigned>(std::strtoul(v, nullptr, 10));
+        else { usage(); return 2; }
+    }
+    if (size <= 1 || queries <= 0 || threads <= 0) { usage(); return 2; }
+
+    std::mt19937 rng(seed);
+    Grid g;
+    if (!csv.empty()) {
+        auto lr = load_csv_ex(csv);
+        if (!lr.grid) { std::cerr << "map load failed: " << csv << "\n"; return 1; }
+        g = std::move(*lr.grid);
+    } else {
+        g = random_grid(size, rng);
+    }
+    std::vector<int32_t> occ32(g.occ.begin(), g.occ.end());
+
+    // 通れるセルの中から始点・終点を選ぶ
+    std::vector<Cell> free_cells;
+    for (int r = 0; r < g.rows; ++r)
+        for (int c = 0; c < g.cols; ++c)
+            if (g.at(r, c) < AstarConfig{}.block_threshold) free_cells.push_back({r, c});
+    if (free_cells.size() < 2) { std::cerr << "map has no free cells\n"; return 1; }
+    std::vector<Query> qs(queries);
+    for (auto& q : qs) {
+        q.s = free_cells[rng() % free_cells.size()];
+        q.g = free_cells[rng() % free_cells.size()];
+    }
+
+    std::cout << "map: " << g.rows << "x" << g.cols << " queries: " << queries << " threads: " << threads << "\n";
+    std::printf("%-6s %14s %12s %10s %10s %8s\n", "mode", "allocs/query", "queries/s", "p50_us", "p99_us", "ok");
+
+    const struct { Mode mode; const char* name; } modes[] = {
+        {Mode::Heap, "heap"}, {Mode::Arena, "arena"}, {Mode::CApi, "capi"}};
+    for (const auto& m : modes) {
+        std::vector<ThreadResult> res(threads);
+        const auto t0 = std::chrono::steady_clock::now();
+        std::vector<std::thread> ts;
+        for (int t = 0; t < threads; ++t)
+            ts.emplace_back(run_thread, m.mode, std::cref(g), std::cref(occ32), std::cref(qs), diag, std::ref(res[t]));
+        for (auto& t : ts) t.join();
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        LatencyHistogram hist;
+        uint64_t allocs = 0, total = 0, ok = 0;
+        for (const auto& r : res) {
+            hist.merge(r.hist);
+            allocs += r.allocs;
+            total += r.queries;
+            ok += r.ok;
+        }
+        // 暖機の分も含めた時間なので、測定分の2倍のクエリを流したものとして割る
+        std::printf("%-6s %14.2f %12.0f %10.1f %10.1f %8llu\n", m.name,
+                    static_cast<double>(allocs) / total, 2.0 * total / sec,
+                    hist.percentile(0.5) * 1000.0, hist.percentile(0.99) * 1000.0,
+                    static_cast<unsigned long long>(ok));
+    }
+    return 0;
+}
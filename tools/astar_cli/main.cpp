@@ -1,18 +1,74 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <optional>
+#include <chrono>
 #include "engine/grid.hpp"
 #include "engine/astar.hpp"
+#include "engine/cpd.hpp"
+#include "engine/subgoal.hpp"
+#include "engine/any_angle.hpp"
+#include "engine/trace.hpp"
+#include "engine/cooperative.hpp"
+#include "engine/realtime.hpp"
+#include "engine/arena.hpp"
 
 using namespace engine;
 
+// コスト倍率表の読み込み（カンマ/空白区切りで occ=0 から順に最大101個、足りない分は既定値）
+static bool load_cost_table(const std::string& path, OccupancyCostTable& t) {
+    std::ifstream ifs(path);
+    if (!ifs) return false;
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    std::string text = ss.str();
+    for (char& ch : text) if (ch == ',') ch = ' ';
+    std::istringstream is(text);
+    t = default_occupancy_costs();
+    int v, i = 0;
+    while (i < static_cast<int>(t.size()) && is >> v) {
+        if (v < 0 || v > 65535) return false;
+        t[i++] = static_cast<uint16_t>(v);
+    }
+    return i > 0;
+}
+
+// エージェント一覧の読み込み（1行に "sx sy gx gy"、'#' 以降は無視）
+static bool load_agents(const std::string& path, std::vector<AgentTask>& tasks) {
+    std::ifstream ifs(path);
+    if (!ifs) return false;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream is(line);
+        int sx, sy, gx, gy;
+        if (!(is >> sx)) continue;
+        if (!(is >> sy >> gx >> gy)) return false;
+        tasks.push_back({{sy, sx}, {gy, gx}}); // (x,y) → (r,c)
+    }
+    return true;
+}
+
 int main(int argc, char** argv) {
-    std::string csv, pgm, yaml, heur="octile", outpath;
+    std::string csv, pgm, yaml, heur="octile", outpath, cost="uniform", cost_table, encode, engine="astar", trace_path, agents_path, build_cpd_path, cpd_path, build_ssg_path, ssg_path;
     int sx=0, sy=0, gx=0, gy=0, block=50; bool diag=true, json=false, explain=false, print_path=false;
+    long long mem_budget=0;
+    int repeat=1; bool histogram=false;
+    int realtime=0, realtime_moves=4;
+    double inflate=0.0; bool inflate_m=false, any_angle=false, smooth=false;
 
     auto need = [&]{ std::cerr <<
         "Usage: astar_cli --csv <file> --start x y --goal x y "
         "[--diag 0|1] [--heuristic manhattan|euclidean|octile] [--block 50] "
+        "[--inflate cells] [--inflate-m meters] "
+        "[--cost uniform|occupancy] [--cost-table file] "
+        "[--build-cpd out.cpd] [--cpd file.cpd] "
+        "[--build-subgoals out.ssg] [--subgoals file.ssg] "
+        "[--any-angle] [--smooth] [--encode moves|rle] "
+        "[--engine astar|fringe|ida] [--mem-budget bytes] "
+        "[--trace out.json] [--histogram] [--repeat N] [--agents file] "
+        "[--realtime lookahead] [--realtime-moves N] "
         "[--json] [--explain] [--print-path]\n"; };
 
     for (int i=1;i<argc;++i){
@@ -27,11 +83,40 @@ int main(int argc, char** argv) {
         else if (a=="--diag")  { int v; nexti(v); diag = (v!=0); }
         else if (a=="--heuristic") nexts(heur);
         else if (a=="--block") nexti(block);
+        else if (a=="--inflate")   { std::string v; nexts(v); inflate = std::stod(v); inflate_m = false; }
+        else if (a=="--inflate-m") { std::string v; nexts(v); inflate = std::stod(v); inflate_m = true; }
+        else if (a=="--cost") nexts(cost);
+        else if (a=="--cost-table") nexts(cost_table);
+        else if (a=="--build-cpd") nexts(build_cpd_path);
+        else if (a=="--cpd") nexts(cpd_path);
+        else if (a=="--build-subgoals") nexts(build_ssg_path);
+        else if (a=="--subgoals") nexts(ssg_path);
+        else if (a=="--any-angle") any_angle = true;
+        else if (a=="--smooth") smooth = true;
+        else if (a=="--encode") nexts(encode);
+        else if (a=="--engine") nexts(engine);
+        else if (a=="--mem-budget") { std::string v; nexts(v); mem_budget = std::stoll(v); }
+        else if (a=="--trace") nexts(trace_path);
+        else if (a=="--agents") nexts(agents_path);
+        else if (a=="--realtime") nexti(realtime);
+        else if (a=="--realtime-moves") nexti(realtime_moves);
+        else if (a=="--histogram") histogram = true;
+        else if (a=="--repeat") nexti(repeat);
         else if (a=="--json")  json = true;
         else if (a=="--explain") explain = true;
         else if (a=="--print-path") print_path = true;
     }
     if (csv.empty() && (pgm.empty() || yaml.empty())) { need(); return 2; }
+    if (repeat < 1) repeat = 1;
+
+    // --trace: 読み込みから記録し、終了時に Chrome trace JSON で書き出す
+    TraceRecorder recorder;
+    if (!trace_path.empty()) set_trace_recorder(&recorder);
+    auto save_trace = [&] {
+        if (trace_path.empty()) return;
+        set_trace_recorder(nullptr);
+        if (!recorder.save_chrome_json(trace_path)) std::cerr << "Failed to write trace\n";
+    };
 
     std::optional<Grid> g = !csv.empty() ? load_csv(csv) : load_pgm_yaml(pgm,yaml);
     if (!g) { std::cerr << "Failed to load map\n"; return 2; }
@@ -42,9 +127,187 @@ int main(int argc, char** argv) {
     if (heur=="manhattan") cfg.heuristic = Heuristic::Manhattan;
     else if (heur=="euclidean") cfg.heuristic = Heuristic::Euclidean;
     else cfg.heuristic = Heuristic::Octile;
+    cfg.inflation_radius = static_cast<float>(inflate);
+    cfg.inflation_unit = inflate_m ? RadiusUnit::Meters : RadiusUnit::Cells;
+    if (engine=="fringe") cfg.engine = SearchEngine::Fringe;
+    else if (engine=="ida") cfg.engine = SearchEngine::IdaStar;
+    cfg.memory_budget_bytes = mem_budget > 0 ? static_cast<size_t>(mem_budget) : 0;
+    if (encode=="moves") cfg.path_format = PathFormat::Moves;
+    else if (encode=="rle") cfg.path_format = PathFormat::RunLength;
+    OccupancyCostTable table{};
+    if (cost=="occupancy") {
+        cfg.cost_mode = CostMode::OccupancyWeighted;
+        if (!cost_table.empty()) {
+            if (!load_cost_table(cost_table, table)) { std::cerr << "Failed to load cost table\n"; return 2; }
+            cfg.cost_table = &table;
+        }
+    }
+
+    auto exit_code = [](PlanStatus s) {
+        switch (s) {
+        case PlanStatus::Ok: return 0;
+        case PlanStatus::NoPath: return 2;
+        case PlanStatus::InvalidArg: return 3;
+        case PlanStatus::OutOfBounds: return 4;
+        case PlanStatus::MapError: return 5;
+        case PlanStatus::Cancelled: return 6;
+        case PlanStatus::ResourceLimit: return 7;
+        }
+        return 5;
+    };
+
+    // --build-cpd: 経路データベースを事前計算して保存し、構築時間とサイズを表示
+    if (!build_cpd_path.empty()) {
+        auto db = build_cpd(*g, cfg);
+        if (!db || !save_cpd(*db, build_cpd_path)) { std::cerr << "Failed to build cpd\n"; return 2; }
+        std::cout << "cpd_build_ms: " << db->stats.build_ms << "\n"
+                  << "cpd_bytes: " << db->stats.bytes << "\n"
+                  << "cpd_runs: " << db->stats.runs << "\n"
+                  << "cpd_sources: " << db->stats.sources << "\n"
+                  << "cpd_threads: " << db->stats.threads << "\n";
+        return 0;
+    }
+
+    // --build-subgoals: サブゴールグラフを構築して保存
+    if (!build_ssg_path.empty()) {
+        auto sg = build_subgoal_graph(*g, cfg);
+        if (!sg || !save_subgoal_graph(*sg, build_ssg_path)) { std::cerr << "Failed to build subgoal graph\n"; return 2; }
+        std::cout << "subgoal_build_ms: " << sg->stats.build_ms << "\n"
+                  << "subgoals: " << sg->stats.subgoals << "\n"
+                  << "subgoal_edges: " << sg->stats.edges << "\n"
+                  << "subgoal_threads: " << sg->stats.threads << "\n";
+        return 0;
+    }
+
+    // --agents: 一覧の順を優先度として協調計画し、スループットを表示（--print-path で "agent t x y"）
+    if (!agents_path.empty()) {
+        std::vector<AgentTask> tasks;
+        if (!load_agents(agents_path, tasks)) { std::cerr << "Failed to load agents\n"; return 2; }
+        auto co = cooperative_plan_ex(*g, tasks, cfg);
+        save_trace();
+        if (!co.result.has_value()) {
+            std::cerr << "found: no\n";
+            return exit_code(co.status);
+        }
+        const auto& st = co.result->stats;
+        if (json) {
+            std::cout << "{\"agents\":" << tasks.size()
+                      << ",\"planned\":" << st.planned
+                      << ",\"failed\":" << st.failed
+                      << ",\"makespan\":" << st.makespan
+                      << ",\"expanded\":" << st.expanded
+                      << ",\"time_ms\":" << st.time_ms
+                      << ",\"agents_per_sec\":" << st.agents_per_sec
+                      << ",\"reservations\":" << st.reservations
+                      << ",\"table_bytes\":" << st.table_bytes << "}\n";
+            return exit_code(co.status);
+        }
+        std::cout << "agents: " << tasks.size() << "\n"
+                  << "planned: " << st.planned << "\n"
+                  << "failed: " << st.failed << "\n"
+                  << "makespan: " << st.makespan << "\n"
+                  << "expanded: " << st.expanded << "\n"
+                  << "time_ms: " << st.time_ms << "\n"
+                  << "agents_per_sec: " << st.agents_per_sec << "\n"
+                  << "reservations: " << st.reservations << "\n"
+                  << "table_bytes: " << st.table_bytes << "\n";
+        if (print_path) {
+            for (size_t a = 0; a < co.result->agents.size(); ++a) {
+                const auto& path = co.result->agents[a].path;
+                for (size_t t = 0; t < path.size(); ++t) std::cout << a << " " << t << " " << path[t].c << " " << path[t].r << "\n";
+            }
+        }
+        return exit_code(co.status);
+    }
+
+    // --realtime: 先読み lookahead の LSS-LRTA* で tick を繰り返してゴールまで進む
+    if (realtime > 0) {
+        RealtimeConfig rcfg;
+        rcfg.lookahead = realtime;
+        rcfg.max_moves = realtime_moves;
+        RealtimeAgent agent(*g, {gy,gx}, cfg, rcfg);
+        std::vector<Cell> walked{{sy,sx}};
+        RealtimeStep step;
+        int ticks = 0, max_expanded = 0;
+        double max_tick_ms = 0.0;
+        const int max_ticks = 4 * g->rows * g->cols;
+        for (; ticks < max_ticks; ++ticks) {
+            auto q0 = std::chrono::steady_clock::now();
+            step = agent.tick(walked.back());
+            auto q1 = std::chrono::steady_clock::now();
+            max_tick_ms = std::max(max_tick_ms, std::chrono::duration<double, std::milli>(q1 - q0).count());
+            max_expanded = std::max(max_expanded, step.expanded);
+            if (step.status != PlanStatus::Ok || step.at_goal || step.moves.empty()) break;
+            walked.insert(walked.end(), step.moves.begin(), step.moves.end());
+        }
+        save_trace();
+        if (step.status == PlanStatus::Ok && !step.at_goal) step.status = PlanStatus::NoPath; // tick 数の上限
+        if (step.status != PlanStatus::Ok) {
+            std::cerr << "found: no\n";
+            return exit_code(step.status);
+        }
+        std::cout << "found: yes\n";
+        if (print_path) for (const auto& p : walked) std::cout << p.c << " " << p.r << "\n";
+        std::cout << "ticks: " << ticks << "\n"
+                  << "length_cells: " << walked.size() << "\n"
+                  << "max_tick_expanded: " << max_expanded << "\n"
+                  << "max_tick_ms: " << max_tick_ms << "\n"
+                  << "learned_cells: " << agent.learned_cells() << "\n";
+        return 0;
+    }
+
+    std::optional<CompressedPathDb> db;
+    std::optional<SubgoalGraph> sg;
+    if (!cpd_path.empty()) {
+        db = load_cpd(cpd_path, *g, cfg);
+        if (!db) { std::cerr << "Failed to load cpd (corrupt, or built for another map/config)\n"; return 2; }
+    } else if (!ssg_path.empty()) {
+        sg = load_subgoal_graph(ssg_path, *g);
+        if (!sg) { std::cerr << "Failed to load subgoal graph (corrupt, or built for another map)\n"; return 2; }
+    }
+
+    // A* はスレッドのアリーナと結果バッファを使い回す（クエリごとにアリーナを巻き戻す）
+    QueryArena& arena = thread_query_arena();
+    cfg.memory = &arena;
+    PlanResult buf;
 
     // 注意：CLIは (x,y) 入力 → 内部は (r,c)=(y,x)
-    auto out = astar_plan_ex(*g, {sy,sx}, {gy,gx}, cfg);
+    auto plan_once = [&]() -> PlanStatus {
+        auto take = [&](PlanOutcome&& o) {
+            if (o.result) buf = std::move(*o.result);
+            return o.status;
+        };
+        if (db) return take(cpd_plan_ex(*db, {sy,sx}, {gy,gx}));
+        if (sg) return take(subgoal_plan_ex(*sg, *g, {sy,sx}, {gy,gx}));
+        if (any_angle) return take(lazy_theta_plan_ex(*g, {sy,sx}, {gy,gx}, cfg));
+        arena.reset();
+        return astar_plan_into(*g, {sy,sx}, {gy,gx}, cfg, buf);
+    };
+
+    // --repeat: 同じクエリを繰り返し、1件ごとの所要時間をヒストグラムに集める（結果は最後のもの）
+    LatencyHistogram hist;
+    PlanOutcome out;
+    for (int i = 0; i < repeat; ++i) {
+        auto q0 = std::chrono::steady_clock::now();
+        out.status = plan_once();
+        auto q1 = std::chrono::steady_clock::now();
+        hist.record_ns(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(q1 - q0).count()));
+    }
+    if (out.status == PlanStatus::Ok) out.result = std::move(buf);
+    save_trace();
+
+    // --encode: 符号化した経路のバイト数を控えておき、表示用にセル列へ戻す
+    long encoded_bytes = -1;
+    if (out.result.has_value() && out.result->compact.has_value()) {
+        encoded_bytes = static_cast<long>(out.result->compact->data.size());
+        out.result->path = decode_path(*out.result->compact);
+    }
+
+    // --smooth: 見通しのある限り飛ばして折れ点だけにする（cost は折れ点列の長さ）
+    if (smooth && out.result.has_value()) {
+        out.result->path = smooth_path(*g, cfg, out.result->path);
+        out.result->stats.cost = polyline_length(out.result->path);
+    }
 
     if (json) {
         std::cout << "{"
@@ -53,22 +316,34 @@ int main(int argc, char** argv) {
             std::cout << ",\"cost\":" << out.result->stats.cost
                     << ",\"expanded\":" << out.result->stats.expanded
                     << ",\"time_ms\":" << out.result->stats.time_ms
-                    << ",\"length_cells\":" << out.result->path.size();
+                    << ",\"length_cells\":" << out.result->path.size()
+                    << ",\"peak_bytes\":" << out.result->stats.peak_bytes;
+            if (encoded_bytes >= 0) std::cout << ",\"encoded_bytes\":" << encoded_bytes;
+        }
+        if (histogram) {
+            std::cout << ",\"latency_ms\":{"
+                    << "\"count\":" << hist.count()
+                    << ",\"mean\":" << hist.mean_ms()
+                    << ",\"min\":" << hist.min_ms()
+                    << ",\"p50\":" << hist.percentile(0.5)
+                    << ",\"p99\":" << hist.percentile(0.99)
+                    << ",\"p999\":" << hist.percentile(0.999)
+                    << ",\"max\":" << hist.max_ms() << "}";
         }
         std::cout << "}\n";
         return 0;
     }
 
-    auto exit_code = [](PlanStatus s) {
-        switch (s) {
-        case PlanStatus::Ok: return 0;
-        case PlanStatus::NoPath: return 2;
-        case PlanStatus::InvalidArg: return 3;
-        case PlanStatus::OutOfBounds: return 4;
-        case PlanStatus::MapError: return 5;
-        }
-        return 5;
-    };
+    // --histogram: 失敗したクエリも含めた遅延分布
+    if (histogram) {
+        std::cout << "latency_count: " << hist.count() << "\n"
+                  << "latency_mean_ms: " << hist.mean_ms() << "\n"
+                  << "latency_min_ms: " << hist.min_ms() << "\n"
+                  << "latency_p50_ms: " << hist.percentile(0.5) << "\n"
+                  << "latency_p99_ms: " << hist.percentile(0.99) << "\n"
+                  << "latency_p999_ms: " << hist.percentile(0.999) << "\n"
+                  << "latency_max_ms: " << hist.max_ms() << "\n";
+    }
 
     // 経路が見つからない場合
     if(out.status != PlanStatus::Ok) {
@@ -86,6 +361,12 @@ int main(int argc, char** argv) {
                 case PlanStatus::MapError:
                     std::cerr << "Map error\n";
                     break;
+                case PlanStatus::Cancelled:
+                    std::cerr << "Cancelled\n";
+                    break;
+                case PlanStatus::ResourceLimit:
+                    std::cerr << "Memory budget exceeded\n";
+                    break;
             }
         }
         // 非JSONの失敗時はstderr側に統一
@@ -111,6 +392,8 @@ int main(int argc, char** argv) {
         std::cout << "cost: " << stats.cost << "\n";
         std::cout << "time_ms: " << stats.time_ms << "\n";
         std::cout << "length_cells: " << out.result->path.size() << "\n";
+        std::cout << "peak_bytes: " << stats.peak_bytes << "\n";
+        if (encoded_bytes >= 0) std::cout << "encoded_bytes: " << encoded_bytes << "\n";
     }
 
     return 0;